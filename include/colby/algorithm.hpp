@@ -7,6 +7,9 @@
 #include "hash.hpp"
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/types.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -34,11 +37,73 @@ inline bool valid (const cv::Mat & mat, cv::Point loc) noexcept {
 	return true;
 }
 
+/**
+ *	A neighborhood policy which considers the four
+ *	points which share an edge with a point to be its
+ *	neighbors.
+ */
+class four_neighborhood {
+public:
+	/**
+	 *	\em true if diagonally adjacent points are
+	 *	neighbors, \em false otherwise.
+	 */
+	static constexpr bool diagonal = false;
+	/**
+	 *	Generates a callback for each point in the
+	 *	neighborhood of a given point without regard
+	 *	for whether or not it is valid.
+	 *
+	 *	\tparam Callback
+	 *		The type of functor which shall be invoked.
+	 *
+	 *	\param [in] p
+	 *		A cv::Point.
+	 *	\param [in] callback
+	 *		An instance of type \em Callback which shall
+	 *		be invoked and passed each neighbor as a
+	 *		cv::Point as its sole argument.
+	 */
+	template <typename Callback>
+	static void visit (cv::Point p, Callback && callback) {
+		callback(cv::Point(p.x - 1,p.y));
+		callback(cv::Point(p.x + 1,p.y));
+		callback(cv::Point(p.x,p.y + 1));
+		callback(cv::Point(p.x,p.y - 1));
+	}
+};
+
+/**
+ *	A neighborhood policy which considers the eight
+ *	points which share an edge or a corner with a point
+ *	to be its neighbors.
+ */
+class eight_neighborhood {
+public:
+	static constexpr bool diagonal = true;
+	template <typename Callback>
+	static void visit (cv::Point p, Callback && callback) {
+		four_neighborhood::visit(p,callback);
+		callback(cv::Point(p.x - 1,p.y - 1));
+		callback(cv::Point(p.x + 1,p.y - 1));
+		callback(cv::Point(p.x - 1,p.y + 1));
+		callback(cv::Point(p.x + 1,p.y + 1));
+	}
+};
+
 /**
  *	Generates a callback for each valid point in
- *	the four-neighborhood of a given point within
- *	a given image.
+ *	the neighborhood of a given point within a given
+ *	image.
  *
+ *	For points which do not lie on the edge of the
+ *	image no bounds checks are performed on the
+ *	individual neighbors.
+ *
+ *	\tparam Neighborhood
+ *		The neighborhood policy, either \ref four_neighborhood
+ *		or \ref eight_neighborhood.  Defaults to
+ *		\ref four_neighborhood.
  *	\tparam Callback
  *		The type of functor which shall be invoked.
  *
@@ -52,25 +117,34 @@ inline bool valid (const cv::Mat & mat, cv::Point loc) noexcept {
  *		be invoked and passed each valid neighbor as
  *		a cv::Point as its sole argument.
  */
-template <typename Callback>
+template <typename Neighborhood = four_neighborhood, typename Callback>
 void neighbors (const cv::Mat & mat, cv::Point start, Callback callback) {
-	cv::Point left(start.x - 1,start.y);
-	if (valid(mat,left)) callback(left);
-	cv::Point right(start.x + 1, start.y);
-	if (valid(mat,right)) callback(right);
-	cv::Point up(start.x,start.y + 1);
-	if (valid(mat,up)) callback(up);
-	cv::Point down(start.x,start.y - 1);
-	if (valid(mat,down)) callback(down);
+	//	Unsigned comparison also rejects negative
+	//	coordinates
+	if (
+		(unsigned(start.x - 1) < unsigned(mat.cols - 2)) &&
+		(unsigned(start.y - 1) < unsigned(mat.rows - 2))
+	) {
+		Neighborhood::visit(start,callback);
+		return;
+	}
+	Neighborhood::visit(start,[&] (cv::Point p) {
+		if (valid(mat,p)) callback(p);
+	});
 }
 
 /**
- *	Performs a flood fill using the four-neighborhood
- *	of visited points.
+ *	Performs a flood fill using the neighborhood of
+ *	visited points.
  *
+ *	\tparam Neighborhood
+ *		The neighborhood policy.  Defaults to
+ *		\ref four_neighborhood.
  *	\tparam Callback
  *		The type of callback which shall be invoked to
  *		determine whether points are included or excluded.
+ *	\tparam Set
+ *		The type of set which shall be returned.
  *
  *	\param [in] mat
  *		The image in which to search.
@@ -85,7 +159,8 @@ void neighbors (const cv::Mat & mat, cv::Point start, Callback callback) {
  *		considered point shall be included, \em false indicates
  *		that it shall be excluded.
  *	\param [in] retr
- *		An std::unordered_set which will be used to build
+ *		A set of cv::Point objects (by default a
+ *		std::unordered_set) which will be used to build
  *		the return value.  It will be cleared before the
  *		return value is built.  This allows for preallocated
  *		memory to be provided.
@@ -98,8 +173,8 @@ void neighbors (const cv::Mat & mat, cv::Point start, Callback callback) {
  *	\return
  *		The set of points which matched.
  */
-template <typename Callback>
-std::unordered_set<cv::Point> flood_fill (const cv::Mat & mat, cv::Point start, Callback callback, std::unordered_set<cv::Point> retr, std::vector<cv::Point> & stack = std::vector<cv::Point>{}) {
+template <typename Neighborhood = four_neighborhood, typename Callback, typename Set>
+Set flood_fill (const cv::Mat & mat, cv::Point start, Callback callback, Set retr, std::vector<cv::Point> & stack) {
 	retr.clear();
 	if (!callback(start)) return retr;
 	stack.clear();
@@ -108,7 +183,7 @@ std::unordered_set<cv::Point> flood_fill (const cv::Mat & mat, cv::Point start,
 	do {
 		auto p = std::move(stack.back());
 		stack.pop_back();
-		neighbors(mat,p,[&] (auto && p) {
+		neighbors<Neighborhood>(mat,p,[&] (auto && p) {
 			if (retr.count(p) != 0) return;
 			if (!callback(p)) return;
 			stack.push_back(p);
@@ -117,10 +192,145 @@ std::unordered_set<cv::Point> flood_fill (const cv::Mat & mat, cv::Point start,
 	} while (!stack.empty());
 	return retr;
 }
-template <typename Callback>
-std::unordered_set<cv::Point> flood_fill (const cv::Mat & mat, cv::Point start, Callback callback, std::unordered_set<cv::Point> retr = std::unordered_set<cv::Point>{}) {
+template <typename Neighborhood = four_neighborhood, typename Callback, typename Set = std::unordered_set<cv::Point>>
+Set flood_fill (const cv::Mat & mat, cv::Point start, Callback callback, Set retr = Set{}) {
 	std::vector<cv::Point> stack;
-	return flood_fill(mat,std::move(start),std::move(callback),std::move(retr),stack);
+	return flood_fill<Neighborhood>(mat,std::move(start),std::move(callback),std::move(retr),stack);
+}
+
+/**
+ *	A horizontal run of pixels.
+ */
+class span {
+public:
+	/**
+	 *	The row in which the run lies.
+	 */
+	int y;
+	/**
+	 *	The column of the leftmost pixel in the run.
+	 */
+	int left;
+	/**
+	 *	The column of the rightmost pixel in the run.
+	 */
+	int right;
+};
+
+/**
+ *	Performs a flood fill using the neighborhood of
+ *	visited points, visiting whole horizontal runs
+ *	of pixels at once.
+ *
+ *	Rather than building a set of points the matched
+ *	points are labeled in a caller-provided label image,
+ *	which is also used to determine which points have
+ *	already been included.  Since the label image may be
+ *	reused across calls, a whole image may be partitioned
+ *	by repeated calls with distinct labels without hashing
+ *	any points.
+ *
+ *	As with \ref flood_fill the callback is invoked for
+ *	every point in the four-neighborhood of a matched
+ *	point other than those already carrying \em label,
+ *	including points carrying other labels.
+ *
+ *	\tparam Neighborhood
+ *		The neighborhood policy.  Defaults to
+ *		\ref four_neighborhood.
+ *	\tparam Callback
+ *		The type of callback which shall be invoked to
+ *		determine whether points are included or excluded.
+ *
+ *	\param [in] mat
+ *		The image in which to search.
+ *	\param [in] start
+ *		The point in \em mat at which the search shall
+ *		begin.
+ *	\param [in] callback
+ *		The callback which shall be invoked to test prospective
+ *		points.  The sole parameter shall be a cv::Point
+ *		representing the point under consideration.  A boolean
+ *		value shall be returned: \em true indicates that the
+ *		considered point shall be included, \em false indicates
+ *		that it shall be excluded.
+ *	\param [in,out] labels
+ *		A cv::Mat of type CV_32SC1 with the same dimensions
+ *		as \em mat.  Each point which is included shall be
+ *		set to \em label.
+ *	\param [in] label
+ *		The label to apply.
+ *	\param [in,out] stack
+ *		A std::vector which will be used to hold runs pending
+ *		recursion.  It will be cleared before it is used.  This
+ *		allows for preallocated memory to be provided.
+ *
+ *	\return
+ *		The number of points which matched.
+ */
+template <typename Neighborhood = four_neighborhood, typename Callback>
+std::size_t scanline_flood_fill (const cv::Mat & mat, cv::Point start, Callback callback, cv::Mat & labels, int label, std::vector<span> & stack) {
+	assert(labels.type() == CV_32SC1);
+	assert(labels.rows == mat.rows);
+	assert(labels.cols == mat.cols);
+	if (labels.at<int>(start) == label) return 0;
+	if (!callback(start)) return 0;
+	std::size_t retr = 0;
+	//	Labels the point at the given column of the given
+	//	row if it belongs in the region
+	auto take = [&] (int * row, int x, int y) {
+		if (row[x] == label) return false;
+		if (!callback(cv::Point(x,y))) return false;
+		row[x] = label;
+		++retr;
+		return true;
+	};
+	//	Labels the run of points containing the already
+	//	labeled point at the given column of the given row
+	auto extend = [&] (int * row, int x, int y, bool left) {
+		span s{y,x,x};
+		if (left) while ((s.left > 0) && take(row,s.left - 1,y)) --s.left;
+		while ((s.right < (mat.cols - 1)) && take(row,s.right + 1,y)) ++s.right;
+		return s;
+	};
+	auto row = labels.ptr<int>(start.y);
+	row[start.x] = label;
+	++retr;
+	stack.clear();
+	stack.push_back(extend(row,start.x,start.y,true));
+	do {
+		auto s = stack.back();
+		stack.pop_back();
+		for (int y : {s.y - 1,s.y + 1}) {
+			if ((y < 0) || (y >= mat.rows)) continue;
+			row = labels.ptr<int>(y);
+			//	Diagonal neighbors of the ends of the run
+			//	are also neighbors of the run
+			int left = s.left;
+			int right = s.right;
+			if (Neighborhood::diagonal) {
+				left = std::max(left - 1,0);
+				right = std::min(right + 1,mat.cols - 1);
+			}
+			for (int x = left; x <= right; ++x) {
+				if (!take(row,x,y)) continue;
+				//	Only a run which begins at the leftmost
+				//	column may extend past it to the left,
+				//	other columns have already been tested
+				auto next = extend(row,x,y,x == left);
+				stack.push_back(next);
+				//	The point to the right of the run was
+				//	either excluded or already labeled
+				x = next.right + 1;
+			}
+		}
+	} while (!stack.empty());
+	return retr;
+}
+template <typename Neighborhood = four_neighborhood, typename Callback>
+std::size_t scanline_flood_fill (const cv::Mat & mat, cv::Point start, Callback callback, cv::Mat & labels, int label) {
+	std::vector<span> stack;
+	return scanline_flood_fill<Neighborhood>(mat,start,std::move(callback),labels,label,stack);
 }
 
 }
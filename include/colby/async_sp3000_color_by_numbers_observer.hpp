@@ -0,0 +1,97 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include "sp3000_color_by_numbers_observer.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace colby {
+
+/**
+ *	Forwards events from a \ref sp3000_color_by_numbers
+ *	object to another observer on a dedicated thread.
+ *
+ *	Each event is captured (see
+ *	\ref sp3000_color_by_numbers_observer::base_event::snapshot)
+ *	and placed in a bounded queue from which a single
+ *	consumer thread delivers it.  Capturing an event is
+ *	much cheaper than producing its image, so observers
+ *	which produce images no longer stall the algorithm.
+ *	Events are delivered in the order in which they
+ *	occurred.
+ *
+ *	If the queue is full the algorithm waits for the
+ *	consumer, so that a slow observer cannot cause an
+ *	unbounded number of snapshots to accumulate.
+ */
+class async_sp3000_color_by_numbers_observer : public sp3000_color_by_numbers_observer {
+private:
+	using callback_type = void (sp3000_color_by_numbers_observer::*) (base_event);
+	using queue_type = std::deque<std::pair<callback_type,base_event>>;
+	sp3000_color_by_numbers_observer & o_;
+	std::size_t capacity_;
+	queue_type queue_;
+	//	The number of events which have been removed from
+	//	the queue but not yet delivered
+	std::size_t delivering_;
+	bool done_;
+	std::exception_ptr ex_;
+	std::mutex m_;
+	//	Notified when an event is added to the queue or
+	//	the consumer should stop
+	std::condition_variable produced_;
+	//	Notified when an event has been delivered
+	std::condition_variable consumed_;
+	std::thread t_;
+	void consume ();
+	void enqueue (callback_type, const base_event &);
+	void rethrow ();
+public:
+	async_sp3000_color_by_numbers_observer () = delete;
+	/**
+	 *	Creates a new async_sp3000_color_by_numbers_observer
+	 *	and starts its consumer thread.
+	 *
+	 *	\param [in] o
+	 *		The observer to which events shall be
+	 *		delivered.  Must remain valid for the
+	 *		lifetime of this object.
+	 *	\param [in] capacity
+	 *		The maximum number of events which may be
+	 *		waiting to be delivered.  Must not be zero.
+	 *		Defaults to 16.
+	 */
+	explicit async_sp3000_color_by_numbers_observer (sp3000_color_by_numbers_observer & o, std::size_t capacity = 16);
+	/**
+	 *	Delivers all outstanding events and then stops
+	 *	the consumer thread.
+	 */
+	~async_sp3000_color_by_numbers_observer () noexcept;
+	/**
+	 *	Waits until every event which has occurred has
+	 *	been delivered.
+	 *
+	 *	If the observer throws while handling an event
+	 *	the events waiting to be delivered are discarded
+	 *	and the exception is thrown by this method or by
+	 *	the handler of the next event to occur, whichever
+	 *	happens first.
+	 */
+	void flush ();
+	virtual void flood_fill (flood_fill_event e) override;
+	virtual void merge_small_cells (merge_small_cells_event e) override;
+	virtual void merge_similar_cells (merge_similar_cells_event e) override;
+	virtual void n_merge (n_merge_event e) override;
+	virtual void p_merge (p_merge_event e) override;
+	virtual void gaussian_smooth (gaussian_smooth_event e) override;
+};
+
+}
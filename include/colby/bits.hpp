@@ -0,0 +1,43 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace colby {
+
+namespace detail {
+
+/**
+ *	Finds the lowest set bit of a mask, such as
+ *	that produced by comparing a vector of bytes.
+ *
+ *	\param [in] mask
+ *		The mask.  Must not be zero.
+ *
+ *	\return
+ *		The index of the lowest set bit.
+ */
+inline std::size_t lowest_set_bit (std::uint32_t mask) noexcept {
+#if defined(_MSC_VER)
+	unsigned long retr;
+	_BitScanForward(&retr,mask);
+	return std::size_t(retr);
+#elif defined(__GNUC__)
+	return std::size_t(__builtin_ctz(mask));
+#else
+	std::size_t retr = 0;
+	for (; (mask & 1U) == 0; mask >>= 1) ++retr;
+	return retr;
+#endif
+}
+
+}
+
+}
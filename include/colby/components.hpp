@@ -0,0 +1,359 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include "algorithm.hpp"
+#include "bits.hpp"
+#include "lab.hpp"
+#include "parallel.hpp"
+#include "union_find.hpp"
+#include <opencv2/core.hpp>
+#include <opencv2/core/mat.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace colby {
+
+namespace detail {
+
+template <typename Neighborhood, typename Color>
+int label_components (const cv::Mat & img, typename lab_traits<Color>::distance_type tolerance, cv::Mat & labels, std::vector<Color> & seeds) {
+	union_find sets;
+	seeds.clear();
+	for (int i = 0; i < img.rows; ++i) {
+		auto in = img.ptr<Color>(i);
+		auto out = labels.ptr<int>(i);
+		auto prev = i == 0 ? nullptr : labels.ptr<int>(i - 1);
+		for (int j = 0; j < img.cols; ++j) {
+			auto c = in[j];
+			int label = -1;
+			//	Considers joining the region of a previously
+			//	visited neighbor
+			auto consider = [&] (int neighbor) noexcept {
+				auto n = sets.find(neighbor);
+				if (n == label) return;
+				if (!(squared_distance(c,seeds[n]) < tolerance)) return;
+				if (label < 0) label = n;
+				else if (squared_distance(seeds[label],seeds[n]) < tolerance) label = sets.unite(label,n);
+			};
+			if (j != 0) consider(out[j - 1]);
+			if (prev) {
+				if (Neighborhood::diagonal && (j != 0)) consider(prev[j - 1]);
+				consider(prev[j]);
+				if (Neighborhood::diagonal && ((j + 1) != img.cols)) consider(prev[j + 1]);
+			}
+			if (label < 0) {
+				label = sets.add();
+				seeds.push_back(c);
+			}
+			out[j] = label;
+		}
+	}
+	std::vector<int> compact(sets.size(),-1);
+	int retr = 0;
+	for (int i = 0; i < labels.rows; ++i) {
+		auto row = labels.ptr<int>(i);
+		for (int j = 0; j < labels.cols; ++j) {
+			auto root = sets.find(row[j]);
+			if (compact[root] < 0) {
+				compact[root] = retr;
+				//	Since representatives are always the smallest
+				//	element of their set and sets are numbered in
+				//	raster order this never overwrites a seed which
+				//	is yet to be moved
+				seeds[retr] = seeds[root];
+				++retr;
+			}
+			row[j] = compact[root];
+		}
+	}
+	seeds.resize(retr);
+	return retr;
+}
+
+//	Finds the end of the run of pixels equal to the pixel
+//	at begin
+template <typename Index>
+int run_end (const Index * row, int begin, int cols) noexcept {
+	auto value = row[begin];
+	int retr = begin + 1;
+	while ((retr != cols) && (row[retr] == value)) ++retr;
+	return retr;
+}
+
+#ifdef __SSE2__
+inline int run_end (const std::uint8_t * row, int begin, int cols) noexcept {
+	auto value = _mm_set1_epi8(char(row[begin]));
+	int retr = begin + 1;
+	for (; (retr + 16) <= cols; retr += 16) {
+		auto mask = std::uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + retr)),value)));
+		if (mask != 0xFFFFU) return retr + int(lowest_set_bit(~mask));
+	}
+	return run_end<std::uint8_t>(row,retr - 1,cols);
+}
+#endif
+
+}
+
+/**
+ *	Partitions an image into regions of similar color
+ *	using a single raster scan.
+ *
+ *	Each region has a seed: the color of the first of its
+ *	pixels in raster order.  A pixel joins the region of
+ *	its left or upper neighbor if its color is within
+ *	\em tolerance of that region's seed.  Where a pixel
+ *	could join both the regions of its left and upper
+ *	neighbors those regions are united if their seeds
+ *	are within \em tolerance of one another.  This
+ *	approximates repeatedly flood filling from the first
+ *	unvisited pixel without ever revisiting a pixel.
+ *
+ *	When diagonal neighbors are considered a pixel may
+ *	likewise join or unite the regions of its upper left
+ *	and upper right neighbors.
+ *
+ *	\tparam Color
+ *		The type of each pixel in the image.  There must
+ *		be an overload of \ref squared_distance for this
+ *		type.
+ *	\tparam Neighborhood
+ *		The neighborhood policy, either \ref four_neighborhood
+ *		or \ref eight_neighborhood.  Defaults to
+ *		\ref four_neighborhood.
+ *
+ *	\param [in] img
+ *		The image to partition.
+ *	\param [in] tolerance
+ *		The squared distance below which colors are
+ *		considered similar.
+ *	\param [out] labels
+ *		A cv::Mat which shall be set to an image of type
+ *		CV_32SC1 with the same dimensions as \em img
+ *		wherein each pixel holds the index of its region.
+ *		Regions are numbered in the raster order of their
+ *		first pixel.
+ *
+ *	\return
+ *		The number of regions.
+ */
+template <typename Color, typename Neighborhood = four_neighborhood>
+int label_components (const cv::Mat & img, typename lab_traits<Color>::distance_type tolerance, cv::Mat & labels) {
+	assert(img.type() == lab_traits<Color>::type);
+	labels.create(img.rows,img.cols,CV_32SC1);
+	std::vector<Color> seeds;
+	return detail::label_components<Neighborhood>(img,tolerance,labels,seeds);
+}
+
+/**
+ *	Partitions an image into regions of similar color
+ *	by dividing it into horizontal strips which are
+ *	partitioned concurrently as if by \ref label_components
+ *	and then stitched together.
+ *
+ *	Regions in adjacent strips are united where a pixel
+ *	on the upper edge of the lower strip is within
+ *	\em tolerance of the seed of the region above it
+ *	and the seeds of the two regions are within
+ *	\em tolerance of one another (i.e. where the pixel
+ *	would have united them had the image been scanned
+ *	as a whole).  Where each region is uniform in color,
+ *	or all colors in a region are within \em tolerance of
+ *	one another, the result is identical to that of
+ *	\ref label_components.  Otherwise, since seeds near
+ *	the edges of strips differ, regions may differ
+ *	slightly.
+ *
+ *	The result does not depend on the number of threads
+ *	or the order in which they complete.
+ *
+ *	\tparam Color
+ *		The type of each pixel in the image.  There must
+ *		be an overload of \ref squared_distance for this
+ *		type.
+ *	\tparam Neighborhood
+ *		The neighborhood policy, either \ref four_neighborhood
+ *		or \ref eight_neighborhood.  Defaults to
+ *		\ref four_neighborhood.
+ *
+ *	\param [in] img
+ *		The image to partition.
+ *	\param [in] tolerance
+ *		The squared distance below which colors are
+ *		considered similar.
+ *	\param [out] labels
+ *		A cv::Mat which shall be set to an image of type
+ *		CV_32SC1 with the same dimensions as \em img
+ *		wherein each pixel holds the index of its region.
+ *		Regions are numbered in the raster order of their
+ *		first pixel.
+ *	\param [in] strips
+ *		The number of strips.  If zero the number of
+ *		threads used by OpenCV is used.  Defaults to
+ *		zero.
+ *
+ *	\return
+ *		The number of regions.
+ */
+template <typename Color, typename Neighborhood = four_neighborhood>
+int parallel_label_components (const cv::Mat & img, typename lab_traits<Color>::distance_type tolerance, cv::Mat & labels, std::size_t strips = 0) {
+	assert(img.type() == lab_traits<Color>::type);
+	labels.create(img.rows,img.cols,CV_32SC1);
+	if (strips == 0) strips = std::size_t(cv::getNumThreads());
+	int n = std::max(1,std::min(img.rows,int(strips)));
+	if (n == 1) return label_components<Color,Neighborhood>(img,tolerance,labels);
+	//	The first row of each strip
+	auto begin = [&] (int strip) noexcept {
+		return int((std::int64_t(img.rows) * strip) / n);
+	};
+	std::vector<std::vector<Color>> seeds(n);
+	std::vector<int> offsets(n + 1,0);
+	parallel_for(cv::Range(0,n),[&] (const cv::Range & range) {
+		for (int s = range.start; s < range.end; ++s) {
+			cv::Range rows(begin(s),begin(s + 1));
+			cv::Mat strip(labels.rowRange(rows));
+			offsets[s + 1] = detail::label_components<Neighborhood>(img.rowRange(rows),tolerance,strip,seeds[s]);
+		}
+	},n);
+	for (int s = 0; s < n; ++s) offsets[s + 1] += offsets[s];
+	//	Within each strip regions are numbered in raster
+	//	order, so offsetting them by the number of regions
+	//	in all preceding strips numbers all regions in
+	//	raster order
+	concurrent_union_find sets(offsets[n]);
+	parallel_for(cv::Range(1,n),[&] (const cv::Range & range) {
+		for (int s = range.start; s < range.end; ++s) {
+			int i = begin(s);
+			auto in = img.ptr<Color>(i);
+			auto above = labels.ptr<int>(i - 1);
+			auto below = labels.ptr<int>(i);
+			auto && seeds_above = seeds[s - 1];
+			auto && seeds_below = seeds[s];
+			for (int j = 0; j < img.cols; ++j) {
+				auto && seed_below = seeds_below[below[j]];
+				auto stitch = [&] (int k) noexcept {
+					auto && seed_above = seeds_above[above[k]];
+					if (!(squared_distance(in[j],seed_above) < tolerance)) return;
+					if (!(squared_distance(seed_below,seed_above) < tolerance)) return;
+					sets.unite(above[k] + offsets[s - 1],below[j] + offsets[s]);
+				};
+				if (Neighborhood::diagonal && (j != 0)) stitch(j - 1);
+				stitch(j);
+				if (Neighborhood::diagonal && ((j + 1) != img.cols)) stitch(j + 1);
+			}
+		}
+	},n - 1);
+	//	The representative of each set is its smallest
+	//	element and therefore the first in raster order
+	std::vector<int> compact(offsets[n]);
+	int retr = 0;
+	for (int i = 0; i < offsets[n]; ++i) {
+		auto root = sets.find(i);
+		compact[i] = root == i ? retr++ : compact[root];
+	}
+	parallel_for(cv::Range(0,n),[&] (const cv::Range & range) {
+		for (int s = range.start; s < range.end; ++s) {
+			for (int i = begin(s); i < begin(s + 1); ++i) {
+				auto row = labels.ptr<int>(i);
+				for (int j = 0; j < labels.cols; ++j) row[j] = compact[row[j] + offsets[s]];
+			}
+		}
+	},n);
+	return retr;
+}
+
+/**
+ *	Partitions an image of indices (for example into a
+ *	palette) into regions of equal index.
+ *
+ *	Each row is divided into runs of equal index, and
+ *	runs in adjacent rows which overlap (or touch
+ *	diagonally when diagonal neighbors are considered)
+ *	and have equal indices are united.  Only integer
+ *	comparisons are made, and where SSE2 is available
+ *	runs in 8-bit images are found 16 pixels at a time.
+ *
+ *	\tparam Index
+ *		The type of each pixel in the image, either
+ *		std::uint8_t or int.
+ *	\tparam Neighborhood
+ *		The neighborhood policy, either \ref four_neighborhood
+ *		or \ref eight_neighborhood.  Defaults to
+ *		\ref four_neighborhood.
+ *
+ *	\param [in] img
+ *		The image to partition.
+ *	\param [out] labels
+ *		A cv::Mat which shall be set to an image of type
+ *		CV_32SC1 with the same dimensions as \em img
+ *		wherein each pixel holds the index of its region.
+ *		Regions are numbered in the raster order of their
+ *		first pixel.
+ *
+ *	\return
+ *		The number of regions.
+ */
+template <typename Index, typename Neighborhood = four_neighborhood>
+int label_equal_components (const cv::Mat & img, cv::Mat & labels) {
+	assert(img.elemSize() == sizeof(Index));
+	assert(img.channels() == 1);
+	labels.create(img.rows,img.cols,CV_32SC1);
+	class run {
+	public:
+		int begin;
+		int end;
+	};
+	std::vector<run> runs;
+	//	The first run in each row
+	std::vector<std::size_t> rows(std::size_t(img.rows) + 1,0);
+	union_find sets;
+	int overlap = Neighborhood::diagonal ? 1 : 0;
+	for (int i = 0; i < img.rows; ++i) {
+		auto in = img.ptr<Index>(i);
+		rows[i] = runs.size();
+		for (int j = 0; j < img.cols;) {
+			auto end = detail::run_end(in,j,img.cols);
+			runs.push_back(run{j,end});
+			sets.add();
+			j = end;
+		}
+		if (i == 0) continue;
+		auto above = img.ptr<Index>(i - 1);
+		//	Runs in each row are sorted and disjoint so the
+		//	runs of the previous row which a run overlaps
+		//	never precede those which the previous run
+		//	overlapped
+		auto p = rows[i - 1];
+		for (auto r = rows[i]; r < runs.size(); ++r) {
+			auto curr = runs[r];
+			while ((p < rows[i]) && ((runs[p].end + overlap) <= curr.begin)) ++p;
+			for (auto q = p; (q < rows[i]) && (runs[q].begin < (curr.end + overlap)); ++q) {
+				if (above[runs[q].begin] == in[curr.begin]) sets.unite(int(q),int(r));
+			}
+		}
+	}
+	rows[img.rows] = runs.size();
+	//	Runs are numbered in raster order and the representative
+	//	of each set is its smallest element
+	std::vector<int> compact(runs.size());
+	int retr = 0;
+	for (std::size_t r = 0; r < runs.size(); ++r) {
+		auto root = std::size_t(sets.find(int(r)));
+		compact[r] = (root == r) ? retr++ : compact[root];
+	}
+	parallel_rows(labels,[&] (int i) noexcept {
+		auto out = labels.ptr<int>(i);
+		for (auto r = rows[i]; r < rows[i + 1]; ++r) std::fill(out + runs[r].begin,out + runs[r].end,compact[r]);
+	});
+	return retr;
+}
+
+}
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <opencv2/core/mat.hpp>
+#include <memory>
 
 namespace colby {
 
@@ -31,6 +32,22 @@ public:
 	 *		The generated cv::Mat.
 	 */
 	virtual cv::Mat image () = 0;
+	/**
+	 *	Captures the state from which the image is
+	 *	produced so that the image may be produced
+	 *	later, after that state has changed.
+	 *
+	 *	The default implementation produces the image
+	 *	immediately.  Derived classes should override
+	 *	it where capturing is cheaper than producing
+	 *	the image.
+	 *
+	 *	\return
+	 *		An image_factory which produces the image
+	 *		this object would have produced at the
+	 *		time of the call.
+	 */
+	virtual std::shared_ptr<image_factory> snapshot ();
 };
 
 }
@@ -0,0 +1,75 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <opencv2/core/matx.hpp>
+#include <opencv2/core/types.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace colby {
+
+/**
+ *	Partitions a set of weighted points into clusters
+ *	using Lloyd's algorithm.
+ *
+ *	Each point contributes to the center of its cluster
+ *	and to the compactness in proportion to its weight.
+ *	The result is therefore the same as that of clustering
+ *	a set wherein each point is repeated a number of times
+ *	equal to its weight (as would be done by cv::kmeans)
+ *	but time and memory are proportional to the number of
+ *	distinct points rather than the sum of their weights.
+ *
+ *	Each attempt is seeded using k-means++ and iterated
+ *	using Hamerly's algorithm, which uses the triangle
+ *	inequality to avoid computing most distances between
+ *	points and centers without changing the result.
+ *	Attempts run concurrently and the attempt with the
+ *	lowest compactness is retained.  The result depends
+ *	only on the arguments and not on the number of threads.
+ *
+ *	\param [in] points
+ *		The points to cluster.
+ *	\param [in] weights
+ *		The weight of each point.  Must be the same
+ *		size as \em points and each weight must be
+ *		positive.
+ *	\param [in] k
+ *		The number of clusters.  Must be positive.
+ *	\param [in] criteria
+ *		The criteria for ending each attempt, as for
+ *		cv::kmeans.
+ *	\param [in] attempts
+ *		The number of attempts.
+ *	\param [out] labels
+ *		A std::vector which shall be set to the
+ *		index of the cluster of each point.
+ *	\param [out] centers
+ *		A std::vector which shall be set to the
+ *		center of each cluster.
+ *	\param [in] seed
+ *		The seed from which the seed of each attempt
+ *		is derived.  Defaults to zero.
+ *
+ *	\return
+ *		The compactness of the result: the sum over all
+ *		points of the weight of the point multiplied by
+ *		its squared distance to the center of its cluster.
+ *		If there are no more points than clusters each
+ *		point forms its own cluster and this is zero.
+ */
+double weighted_kmeans (
+	const std::vector<cv::Vec3f> & points,
+	const std::vector<double> & weights,
+	int k,
+	cv::TermCriteria criteria,
+	int attempts,
+	std::vector<int> & labels,
+	std::vector<cv::Vec3f> & centers,
+	std::uint64_t seed = 0
+);
+
+}
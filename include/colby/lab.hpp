@@ -0,0 +1,197 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace colby {
+
+/**
+ *	The number of fractional bits in a fixed point
+ *	CIELAB value.
+ *
+ *	With six fractional bits each channel of every
+ *	CIELAB color obtainable from 8-bit sRGB fits in a
+ *	signed 16-bit integer, and the squared Euclidean
+ *	distance between any two such colors fits in a
+ *	signed 32-bit integer.
+ */
+constexpr int fixed_lab_bits = 6;
+
+/**
+ *	The factor by which each channel of a CIELAB value
+ *	is multiplied to obtain a fixed point CIELAB value.
+ */
+constexpr float fixed_lab_scale = float(1 << fixed_lab_bits);
+
+/**
+ *	Converts a 32-bit floating point CIELAB value to a
+ *	fixed point CIELAB value consisting of three signed
+ *	16-bit integers.
+ *
+ *	Each channel is rounded to the nearest multiple of
+ *	\f$2^{-6}\f$ so the result differs from \em lab by
+ *	no more than \f$2^{-7}\f$ in any channel.
+ *
+ *	\param [in] lab
+ *		The color in CIELAB
+ *	\returns
+ *		The color in fixed point CIELAB
+ */
+inline cv::Vec3s lab2fixed (const cv::Vec3f lab) noexcept {
+	auto convert = [] (float f) noexcept {
+		f = std::round(f * fixed_lab_scale);
+		if (f < float(std::numeric_limits<std::int16_t>::min())) return std::numeric_limits<std::int16_t>::min();
+		if (f > float(std::numeric_limits<std::int16_t>::max())) return std::numeric_limits<std::int16_t>::max();
+		return std::int16_t(f);
+	};
+	return cv::Vec3s(convert(lab[0]),convert(lab[1]),convert(lab[2]));
+}
+
+/**
+ *	Converts a fixed point CIELAB value to a 32-bit
+ *	floating point CIELAB value.
+ *
+ *	\param [in] lab
+ *		The color in fixed point CIELAB
+ *	\returns
+ *		The color in CIELAB
+ */
+inline cv::Vec3f fixed2lab (const cv::Vec3s lab) noexcept {
+	return cv::Vec3f(lab[0] / fixed_lab_scale,lab[1] / fixed_lab_scale,lab[2] / fixed_lab_scale);
+}
+
+/**
+ *	Converts a cv::Mat of 32-bit floating point CIELAB
+ *	values to fixed point CIELAB values.
+ *
+ *	\param [in] lab
+ *		A cv::Mat of CIELAB values
+ *	\returns
+ *		A cv::Mat of fixed point CIELAB values
+ */
+cv::Mat lab2fixed (const cv::Mat & lab);
+
+/**
+ *	Converts a cv::Mat of fixed point CIELAB values to
+ *	32-bit floating point CIELAB values.
+ *
+ *	\param [in] lab
+ *		A cv::Mat of fixed point CIELAB values
+ *	\returns
+ *		A cv::Mat of CIELAB values
+ */
+cv::Mat fixed2lab (const cv::Mat & lab);
+
+/**
+ *	Computes the square of the Euclidean distance
+ *	between two 32-bit floating point CIELAB values.
+ *
+ *	\param [in] a
+ *		A color
+ *	\param [in] b
+ *		A color
+ *
+ *	\return
+ *		The squared distance
+ */
+inline float squared_distance (const cv::Vec3f & a, const cv::Vec3f & b) noexcept {
+	auto diff = a - b;
+	return (diff[0] * diff[0]) + (diff[1] * diff[1]) + (diff[2] * diff[2]);
+}
+
+/**
+ *	Computes the square of the Euclidean distance
+ *	between two fixed point CIELAB values using
+ *	integer arithmetic.
+ *
+ *	\param [in] a
+ *		A color
+ *	\param [in] b
+ *		A color
+ *
+ *	\return
+ *		The squared distance, in units of
+ *		\f$2^{-12}\f$.
+ */
+inline std::int32_t squared_distance (const cv::Vec3s & a, const cv::Vec3s & b) noexcept {
+	std::int32_t l = std::int32_t(a[0]) - b[0];
+	std::int32_t aa = std::int32_t(a[1]) - b[1];
+	std::int32_t bb = std::int32_t(a[2]) - b[2];
+	return (l * l) + (aa * aa) + (bb * bb);
+}
+
+/**
+ *	Describes a representation of CIELAB colors.
+ *
+ *	\tparam Color
+ *		The type which represents a single color.
+ */
+template <typename Color>
+class lab_traits;
+
+/**
+ *	Describes 32-bit floating point CIELAB colors.
+ */
+template <>
+class lab_traits<cv::Vec3f> {
+public:
+	/**
+	 *	The OpenCV type of a cv::Mat holding colors
+	 *	in this representation.
+	 */
+	static constexpr int type = CV_32FC3;
+	/**
+	 *	The type of the squared distance between two
+	 *	colors in this representation.
+	 */
+	using distance_type = float;
+	static cv::Vec3f from_lab (cv::Vec3f lab) noexcept {
+		return lab;
+	}
+	static cv::Vec3f to_lab (cv::Vec3f lab) noexcept {
+		return lab;
+	}
+	/**
+	 *	Converts a squared distance between CIELAB colors
+	 *	to a squared distance in this representation.
+	 *
+	 *	\param [in] d
+	 *		The squared distance.
+	 *
+	 *	\return
+	 *		The squared distance.
+	 */
+	static distance_type from_squared_distance (float d) noexcept {
+		return d;
+	}
+};
+
+/**
+ *	Describes fixed point CIELAB colors.
+ */
+template <>
+class lab_traits<cv::Vec3s> {
+public:
+	static constexpr int type = CV_16SC3;
+	using distance_type = std::int32_t;
+	static cv::Vec3s from_lab (cv::Vec3f lab) noexcept {
+		return lab2fixed(lab);
+	}
+	static cv::Vec3f to_lab (cv::Vec3s lab) noexcept {
+		return fixed2lab(lab);
+	}
+	static distance_type from_squared_distance (float d) noexcept {
+		auto retr = std::ceil(d * fixed_lab_scale * fixed_lab_scale);
+		if (retr > float(std::numeric_limits<distance_type>::max())) return std::numeric_limits<distance_type>::max();
+		return distance_type(retr);
+	}
+};
+
+}
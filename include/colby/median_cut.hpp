@@ -0,0 +1,59 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <opencv2/core/matx.hpp>
+#include <vector>
+
+namespace colby {
+
+/**
+ *	Chooses a palette for a set of weighted points using
+ *	median cut and assigns each point to the nearest
+ *	color in that palette.
+ *
+ *	Beginning with a single box containing every point
+ *	the box whose points have the greatest weighted sum
+ *	of squared distances from their mean is repeatedly
+ *	split at the weighted median of the axis along which
+ *	its points vary most.  Each color in the palette is
+ *	the weighted mean of the points in a box.
+ *
+ *	Unlike \ref weighted_kmeans there is no iteration
+ *	and no randomness: the result depends only on the
+ *	arguments.
+ *
+ *	\param [in] points
+ *		The points to quantize.
+ *	\param [in] weights
+ *		The weight of each point.  Must be the same
+ *		size as \em points and each weight must be
+ *		positive.
+ *	\param [in] k
+ *		The maximum number of colors in the palette.
+ *		Must be positive.  Fewer colors are chosen
+ *		only if there are fewer than \em k distinct
+ *		points.
+ *	\param [out] labels
+ *		A std::vector which shall be set to the index
+ *		within \em palette of the color nearest each
+ *		point.
+ *	\param [out] palette
+ *		A std::vector which shall be set to the chosen
+ *		colors.
+ *
+ *	\return
+ *		The weighted sum of the squared distances from
+ *		each point to the color to which it is assigned.
+ */
+double median_cut (
+	const std::vector<cv::Vec3f> & points,
+	const std::vector<double> & weights,
+	int k,
+	std::vector<int> & labels,
+	std::vector<cv::Vec3f> & palette
+);
+
+}
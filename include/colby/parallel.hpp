@@ -0,0 +1,84 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <utility>
+
+namespace colby {
+
+/**
+ *	Adapts a functor to the cv::ParallelLoopBody
+ *	interface.
+ *
+ *	\tparam Callback
+ *		The type of functor to adapt.
+ */
+template <typename Callback>
+class parallel_loop_body : public cv::ParallelLoopBody {
+private:
+	Callback callback_;
+public:
+	parallel_loop_body () = delete;
+	/**
+	 *	Creates a new parallel_loop_body.
+	 *
+	 *	\param [in] callback
+	 *		The functor which shall be invoked with
+	 *		each cv::Range.
+	 */
+	explicit parallel_loop_body (Callback callback) : callback_(std::move(callback)) {	}
+	virtual void operator () (const cv::Range & range) const override {
+		callback_(range);
+	}
+};
+
+/**
+ *	Invokes a callback for disjoint subranges of a
+ *	range on the threads managed by OpenCV.
+ *
+ *	\tparam Callback
+ *		The type of callback which shall be invoked.
+ *
+ *	\param [in] range
+ *		The range to divide.
+ *	\param [in] callback
+ *		The callback which shall be invoked with each
+ *		subrange as a cv::Range.  The callback must be
+ *		safe to invoke concurrently.
+ *	\param [in] nstripes
+ *		The approximate number of subranges into which
+ *		\em range shall be divided.  If negative OpenCV
+ *		chooses.  Defaults to a negative value.
+ */
+template <typename Callback>
+void parallel_for (cv::Range range, Callback callback, double nstripes = -1.) {
+	cv::parallel_for_(range,parallel_loop_body<Callback>(std::move(callback)),nstripes);
+}
+
+/**
+ *	Invokes a callback for each row of a cv::Mat, with
+ *	rows divided between the threads managed by OpenCV.
+ *
+ *	\tparam Callback
+ *		The type of callback which shall be invoked.
+ *
+ *	\param [in] mat
+ *		The image whose rows shall be visited.
+ *	\param [in] callback
+ *		The callback which shall be invoked with the index
+ *		of each row as its sole argument.  The callback must
+ *		be safe to invoke concurrently.
+ */
+template <typename Callback>
+void parallel_rows (const cv::Mat & mat, Callback callback) {
+	parallel_for(cv::Range(0,mat.rows),[&] (const cv::Range & range) {
+		for (int i = range.start; i < range.end; ++i) callback(i);
+	});
+}
+
+}
@@ -0,0 +1,1063 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include "algorithm.hpp"
+#include "lab.hpp"
+#include "parallel.hpp"
+#include "union_find.hpp"
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <opencv2/core/types.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace colby {
+
+namespace detail {
+
+//	Presents a row of an image of indices into a palette
+//	as a row of colors
+template <typename Index, typename Color>
+class palette_row {
+private:
+	const Index * row_;
+	const Color * palette_;
+public:
+	palette_row (const Index * row, const Color * palette) noexcept : row_(row), palette_(palette) {	}
+	Color operator [] (int j) const noexcept {
+		return palette_[row_[j]];
+	}
+};
+
+//	The cost of merging two neighboring vertices during
+//	N-merging
+template <typename Graph>
+float n_merge_weight (const Graph & g, const typename Graph::neighbors_type & a) {
+	auto bigger = std::max(g.size(a.first),g.size(a.second));
+	return squared_distance(g.color(a.first),g.color(a.second)) * bigger;
+}
+
+}
+
+/**
+ *	A graph whose vertices are regions of an image
+ *	and whose edges join neighboring regions.
+ *
+ *	Vertices are identified by dense integer ids and
+ *	their attributes are stored in parallel arrays.
+ *	Merging two vertices does not relabel any pixels,
+ *	the pixels owned by each vertex are resolved only
+ *	when an image is produced.
+ *
+ *	\tparam Color
+ *		The type of each color.
+ */
+template <typename Color>
+class region_graph {
+public:
+	using traits = lab_traits<Color>;
+	using vertex = int;
+	/**
+	 *	The border between two neighboring vertices as
+	 *	seen from one of them.
+	 */
+	class edge {
+	public:
+		/**
+		 *	The other vertex.
+		 */
+		vertex to;
+		/**
+		 *	The number of pairs of neighboring pixels
+		 *	of which one is owned by each vertex.
+		 */
+		std::size_t border;
+		/**
+		 *	The sum of the distances between the colors
+		 *	(in CIELAB) of those pairs of pixels.
+		 */
+		double gradient;
+	};
+	using adjacency_list = std::vector<edge>;
+	using neighbors_type = std::pair<vertex,vertex>;
+private:
+	//	The vertex which initially owned each pixel,
+	//	which must be copied before being modified if
+	//	it has been captured
+	cv::Mat labels_;
+	bool captured_;
+	//	Merged vertices are united, the vertex which
+	//	now owns the pixels of each set is recorded
+	//	against its representative.  Finding owners
+	//	compresses paths, which does not change the
+	//	observable state of the graph
+	mutable sized_union_find sets_;
+	std::vector<vertex> owners_;
+	std::vector<std::size_t> sizes_;
+	std::vector<cv::Vec3d> sums_;
+	std::vector<Color> colors_;
+	//	Sorted by target
+	std::vector<adjacency_list> adjacency_;
+	//	The vertices which have not been merged into
+	//	another vertex, and the position of each
+	//	vertex therein
+	std::vector<vertex> vertices_;
+	std::vector<std::size_t> positions_;
+	//	The number of merges performed on the graph
+	std::size_t merges_;
+	region_graph (cv::Mat labels, int n);
+	template <typename Rows>
+	void build (Rows rows, bool diagonal);
+	void renumber ();
+public:
+	region_graph () = delete;
+	region_graph (const region_graph &) = delete;
+	region_graph (region_graph &&) = delete;
+	region_graph & operator = (const region_graph &) = delete;
+	region_graph & operator = (region_graph &&) = delete;
+	/**
+	 *	Creates a region_graph from an image and a
+	 *	division thereof into regions.
+	 *
+	 *	\param [in] img
+	 *		An image whose pixels are of type \em Color.
+	 *	\param [in] labels
+	 *		An image of type CV_32SC1 wherein each pixel
+	 *		holds the region to which it belongs.
+	 *	\param [in] n
+	 *		The number of regions.  Each label must be
+	 *		in \f$[0,n)\f$ and each region non-empty.
+	 *	\param [in] diagonal
+	 *		\em true if pixels which share a corner are
+	 *		neighbors, \em false otherwise.
+	 */
+	region_graph (const cv::Mat & img, cv::Mat labels, int n, bool diagonal);
+	/**
+	 *	Creates a region_graph from an image represented
+	 *	by indices into a palette and a division thereof
+	 *	into regions.
+	 *
+	 *	\param [in] indices
+	 *		An image of type CV_8UC1 or CV_32SC1 wherein
+	 *		each pixel holds the index of its color within
+	 *		\em palette.
+	 *	\param [in] palette
+	 *		The colors.
+	 *	\param [in] labels
+	 *		An image of type CV_32SC1 wherein each pixel
+	 *		holds the region to which it belongs.
+	 *	\param [in] n
+	 *		The number of regions.
+	 *	\param [in] diagonal
+	 *		\em true if pixels which share a corner are
+	 *		neighbors, \em false otherwise.
+	 */
+	region_graph (const cv::Mat & indices, const std::vector<Color> & palette, cv::Mat labels, int n, bool diagonal);
+	/**
+	 *	Retrieves the vertices which have not been
+	 *	merged into another vertex.  The order is
+	 *	unspecified.
+	 *
+	 *	\return
+	 *		A reference to a std::vector of vertices.
+	 */
+	const std::vector<vertex> & vertices () const noexcept;
+	/**
+	 *	Determines the number of vertices.
+	 *
+	 *	\return
+	 *		The number of vertices.
+	 */
+	std::size_t size () const noexcept;
+	/**
+	 *	Determines the number of pixels owned by a
+	 *	vertex.
+	 *
+	 *	\param [in] v
+	 *		The vertex.
+	 *
+	 *	\return
+	 *		The number of pixels.
+	 */
+	std::size_t size (vertex v) const noexcept;
+	/**
+	 *	Determines the sum of the colors (as they were
+	 *	when the graph was created) of the pixels owned
+	 *	by a vertex.
+	 *
+	 *	\param [in] v
+	 *		The vertex.
+	 *
+	 *	\return
+	 *		The sum.
+	 */
+	cv::Vec3d sum (vertex v) const noexcept;
+	/**
+	 *	Retrieves the color of a vertex.
+	 *
+	 *	\param [in] v
+	 *		The vertex.
+	 *
+	 *	\return
+	 *		The color.
+	 */
+	Color color (vertex v) const noexcept;
+	/**
+	 *	Recolors a vertex.
+	 *
+	 *	\param [in] v
+	 *		The vertex.
+	 *	\param [in] c
+	 *		The color.
+	 */
+	void color (vertex v, Color c) noexcept;
+	/**
+	 *	Retrieves the edges incident on a vertex sorted
+	 *	by \ref edge::to.
+	 *
+	 *	\param [in] v
+	 *		The vertex.
+	 *
+	 *	\return
+	 *		A reference to a std::vector of edges.
+	 */
+	const adjacency_list & neighbors (vertex v) const noexcept;
+	/**
+	 *	Merges one vertex into a neighboring vertex.
+	 *
+	 *	\param [in] into
+	 *		The vertex which shall own the pixels of both.
+	 *	\param [in] from
+	 *		The vertex which shall cease to exist.
+	 *	\param [in] avg
+	 *		If \em true \em into is recolored with the
+	 *		mean of the colors of the pixels of both.
+	 *		Defaults to \em true.
+	 */
+	void merge (vertex into, vertex from, bool avg = true);
+	/**
+	 *	Determines the number of merges performed on
+	 *	the graph.
+	 *
+	 *	\return
+	 *		The number of merges.
+	 */
+	std::size_t merges () const noexcept;
+	/**
+	 *	Renders the graph as an image wherein each pixel
+	 *	has the color of the vertex which owns it.
+	 *
+	 *	\return
+	 *		An image whose pixels are of type \em Color.
+	 */
+	cv::Mat mat () const;
+	/**
+	 *	Produces a label image wherein each pixel holds
+	 *	the index of the vertex which owns it within
+	 *	\ref vertices.
+	 *
+	 *	\param [out] palette
+	 *		A std::vector which shall receive the color of
+	 *		each vertex in the same order.
+	 *
+	 *	\return
+	 *		An image of type CV_32SC1.
+	 */
+	cv::Mat labels (std::vector<Color> & palette) const;
+	/**
+	 *	Captures the state of the graph cheaply such that
+	 *	it may be rendered later.  The label image is
+	 *	shared rather than copied and is copied by the
+	 *	graph before it is next modified.
+	 *
+	 *	\param [out] palette
+	 *		A std::vector which shall receive a color for
+	 *		each label in the returned image.
+	 *
+	 *	\return
+	 *		An image of type CV_32SC1.
+	 */
+	cv::Mat capture (std::vector<Color> & palette);
+	/**
+	 *	Updates the graph so that it is as though it had
+	 *	been created from an image represented by indices
+	 *	into a palette, doing work proportional to the
+	 *	number of pixels whose color changed (except
+	 *	where a vertex may have been split).
+	 *
+	 *	Afterwards vertices are numbered as they would be
+	 *	had the graph been created afresh (i.e. in raster
+	 *	order of their first pixels) so that algorithms
+	 *	which break ties by vertex yield the same results.
+	 *
+	 *	\tparam Neighborhood
+	 *		The neighborhood of each pixel.
+	 *
+	 *	\param [in] indices
+	 *		An image of type CV_8UC1 or CV_32SC1 wherein
+	 *		each pixel holds the index of its color within
+	 *		\em palette.
+	 *	\param [in] palette
+	 *		The colors.
+	 */
+	template <typename Neighborhood>
+	void resegment (const cv::Mat & indices, const std::vector<Color> & palette);
+	/**
+	 *	Determines the vertex which currently owns the
+	 *	pixels of each vertex which has ever existed.
+	 *
+	 *	\return
+	 *		A std::vector indexed by vertex.
+	 */
+	std::vector<vertex> owners () const;
+};
+
+template <typename Color>
+region_graph<Color>::region_graph (cv::Mat labels, int n)
+	:	labels_(std::move(labels)),
+		captured_(false),
+		sets_(n),
+		owners_(n),
+		sizes_(n,0),
+		sums_(n,cv::Vec3d(0,0,0)),
+		colors_(n),
+		adjacency_(n),
+		positions_(n),
+		merges_(0)
+{
+	assert(labels_.type() == CV_32SC1);
+	for (int i = 0; i < labels_.rows; ++i) {
+		auto row = labels_.ptr<int>(i);
+		for (int j = 0; j < labels_.cols; ++j) ++sizes_[row[j]];
+	}
+}
+
+template <typename Color>
+template <typename Rows>
+void region_graph<Color>::build (Rows rows, bool diagonal) {
+	auto add_one = [&] (vertex a, vertex b, double distance) {
+		//	Consecutive pixels along a border usually
+		//	contribute to the same edge
+		auto && list = adjacency_[a];
+		if (list.empty() || (list.back().to != b)) {
+			list.push_back(edge{b,1,distance});
+			return;
+		}
+		++list.back().border;
+		list.back().gradient += distance;
+	};
+	auto add = [&] (vertex a, Color a_color, vertex b, Color b_color) {
+		if (a == b) return;
+		auto distance = std::sqrt(double(squared_distance(traits::to_lab(a_color),traits::to_lab(b_color))));
+		add_one(a,b,distance);
+		add_one(b,a,distance);
+	};
+	for (int i = 0; i < labels_.rows; ++i) {
+		auto in = rows(i);
+		auto in_next = rows(std::min(i + 1,labels_.rows - 1));
+		auto row = labels_.ptr<int>(i);
+		auto next = (i + 1) == labels_.rows ? nullptr : labels_.ptr<int>(i + 1);
+		for (int j = 0; j < labels_.cols; ++j) {
+			auto v = row[j];
+			auto c = in[j];
+			sums_[v] += cv::Vec3d(c[0],c[1],c[2]);
+			if ((j + 1) != labels_.cols) add(v,c,row[j + 1],in[j + 1]);
+			if (!next) continue;
+			add(v,c,next[j],in_next[j]);
+			if (!diagonal) continue;
+			if (j != 0) add(v,c,next[j - 1],in_next[j - 1]);
+			if ((j + 1) != labels_.cols) add(v,c,next[j + 1],in_next[j + 1]);
+		}
+	}
+	int n = int(sizes_.size());
+	vertices_.reserve(n);
+	for (int v = 0; v < n; ++v) {
+		auto && list = adjacency_[v];
+		std::sort(list.begin(),list.end(),[] (const edge & a, const edge & b) noexcept {
+			return a.to < b.to;
+		});
+		//	Combine the edges to each neighbor
+		std::size_t k = 0;
+		for (std::size_t l = 0; l < list.size(); ++l) {
+			if ((k != 0) && (list[k - 1].to == list[l].to)) {
+				list[k - 1].border += list[l].border;
+				list[k - 1].gradient += list[l].gradient;
+				continue;
+			}
+			list[k++] = list[l];
+		}
+		list.resize(k);
+		colors_[v] = sums_[v] * (1.0 / double(sizes_[v]));
+		owners_[v] = v;
+		positions_[v] = vertices_.size();
+		vertices_.push_back(v);
+	}
+}
+
+template <typename Color>
+region_graph<Color>::region_graph (const cv::Mat & img, cv::Mat labels, int n, bool diagonal)
+	:	region_graph(std::move(labels),n)
+{
+	build([&] (int i) noexcept {	return img.ptr<Color>(i);	},diagonal);
+}
+
+template <typename Color>
+region_graph<Color>::region_graph (const cv::Mat & indices, const std::vector<Color> & palette, cv::Mat labels, int n, bool diagonal)
+	:	region_graph(std::move(labels),n)
+{
+	auto build_indexed = [&] (auto index) {
+		using index_type = decltype(index);
+		build([&] (int i) noexcept {	return detail::palette_row<index_type,Color>(indices.ptr<index_type>(i),palette.data());	},diagonal);
+	};
+	if (indices.type() == CV_8UC1) build_indexed(std::uint8_t());
+	else build_indexed(int());
+}
+
+template <typename Color>
+const std::vector<typename region_graph<Color>::vertex> & region_graph<Color>::vertices () const noexcept {
+	return vertices_;
+}
+
+template <typename Color>
+std::size_t region_graph<Color>::size () const noexcept {
+	return vertices_.size();
+}
+
+template <typename Color>
+std::size_t region_graph<Color>::size (vertex v) const noexcept {
+	return sizes_[v];
+}
+
+template <typename Color>
+cv::Vec3d region_graph<Color>::sum (vertex v) const noexcept {
+	return sums_[v];
+}
+
+template <typename Color>
+Color region_graph<Color>::color (vertex v) const noexcept {
+	return colors_[v];
+}
+
+template <typename Color>
+void region_graph<Color>::color (vertex v, Color c) noexcept {
+	colors_[v] = c;
+}
+
+template <typename Color>
+const typename region_graph<Color>::adjacency_list & region_graph<Color>::neighbors (vertex v) const noexcept {
+	return adjacency_[v];
+}
+
+template <typename Color>
+void region_graph<Color>::merge (vertex into, vertex from, bool avg) {
+	//	Note: If anything in this method throws, die
+	//	as the state is corrupted and it's not worth
+	//	the effort to give a strong exception guarantee
+	if (into == from) throw std::logic_error("Loop not allowed");
+	sums_[into] += sums_[from];
+	sizes_[into] += sizes_[from];
+	if (avg) colors_[into] = sums_[into] * (1.0 / double(sizes_[into]));
+	//	Pixels are not relabeled until the label image
+	//	is required
+	owners_[sets_.unite(into,from)] = into;
+	//	Every neighbor of from other than into now neighbors
+	//	into rather than from, and any border it shared with
+	//	from is now shared with into.  The edge is either
+	//	combined with an existing edge to into and erased, or
+	//	retargeted and rotated into place, either of which
+	//	shifts the list of the neighbor once, so the cost is
+	//	linear in the sum of the degrees of the neighbors
+	auto by_target = [] (const edge & e, vertex v) noexcept {
+		return e.to < v;
+	};
+	auto && from_list = adjacency_[from];
+	for (auto && e : from_list) {
+		if (e.to == into) continue;
+		auto && list = adjacency_[e.to];
+		auto iter = std::lower_bound(list.begin(),list.end(),from,by_target);
+		assert(iter != list.end());
+		assert(iter->to == from);
+		auto target = std::lower_bound(list.begin(),list.end(),into,by_target);
+		if ((target != list.end()) && (target->to == into)) {
+			target->border += iter->border;
+			target->gradient += iter->gradient;
+			list.erase(iter);
+			continue;
+		}
+		iter->to = into;
+		if (target > iter) std::rotate(iter,iter + 1,target);
+		else std::rotate(target,iter,iter + 1);
+	}
+	//	Merge the (sorted) lists of neighbors of into and
+	//	from, combining the edges to common neighbors and
+	//	dropping the edge between into and from
+	auto && into_list = adjacency_[into];
+	adjacency_list merged;
+	merged.reserve(into_list.size() + from_list.size());
+	auto a = into_list.begin();
+	auto b = from_list.begin();
+	while ((a != into_list.end()) || (b != from_list.end())) {
+		edge e;
+		if ((b == from_list.end()) || ((a != into_list.end()) && (a->to < b->to))) {
+			e = *(a++);
+		} else if ((a == into_list.end()) || (b->to < a->to)) {
+			e = *(b++);
+		} else {
+			e = *(a++);
+			e.border += b->border;
+			e.gradient += b->gradient;
+			++b;
+		}
+		if ((e.to == into) || (e.to == from)) continue;
+		merged.push_back(e);
+	}
+	into_list.swap(merged);
+	adjacency_list().swap(from_list);
+	//	Remove from from the list of vertices by moving
+	//	the last vertex into its place
+	auto pos = positions_[from];
+	auto last = vertices_.back();
+	vertices_[pos] = last;
+	positions_[last] = pos;
+	vertices_.pop_back();
+	++merges_;
+}
+
+template <typename Color>
+std::size_t region_graph<Color>::merges () const noexcept {
+	return merges_;
+}
+
+template <typename Color>
+template <typename Neighborhood>
+void region_graph<Color>::resegment (const cv::Mat & indices, const std::vector<Color> & palette) {
+	//	Pixels which are being moved between vertices are
+	//	labeled unowned, and pixels of a vertex whose
+	//	connectivity is being checked are labeled pending
+	constexpr int unowned = -1;
+	constexpr int pending = -2;
+	int rows = labels_.rows;
+	int cols = labels_.cols;
+	auto at = [&] (cv::Point p) noexcept -> int & {
+		return labels_.ptr<int>(p.y)[p.x];
+	};
+	auto visit = [&] (cv::Point p, auto && callback) {
+		Neighborhood::visit(p,[&] (cv::Point q) {
+			if ((q.x >= 0) && (q.y >= 0) && (q.x < cols) && (q.y < rows)) callback(q);
+		});
+	};
+	auto by_target = [] (const edge & e, vertex v) noexcept {
+		return e.to < v;
+	};
+	//	Adjusts the number of pairs of neighboring pixels
+	//	shared by two vertices
+	auto border = [&] (vertex a, vertex b, bool add) {
+		auto patch = [&] (vertex from, vertex to) {
+			auto && list = adjacency_[from];
+			auto iter = std::lower_bound(list.begin(),list.end(),to,by_target);
+			if ((iter == list.end()) || (iter->to != to)) {
+				assert(add);
+				list.insert(iter,edge{to,1,0});
+				return;
+			}
+			if (add) ++iter->border;
+			else if (--iter->border == 0) list.erase(iter);
+		};
+		patch(a,b);
+		patch(b,a);
+	};
+	//	Moves a pixel between vertices (either of which may
+	//	be unowned) updating sizes and borders against the
+	//	current owners of its neighbors
+	auto move = [&] (cv::Point p, vertex from, vertex to, auto && owner) {
+		visit(p,[&] (cv::Point q) {
+			auto u = owner(at(q));
+			if (u == unowned) return;
+			if ((from != unowned) && (u != from)) border(from,u,false);
+			if ((to != unowned) && (u != to)) border(to,u,true);
+		});
+		if (from != unowned) --sizes_[from];
+		if (to != unowned) ++sizes_[to];
+	};
+	auto identity = [] (int label) noexcept {	return label;	};
+	auto add = [&] (Color c) {
+		vertex v = sets_.add();
+		owners_.push_back(v);
+		sizes_.push_back(0);
+		sums_.emplace_back(0,0,0);
+		colors_.push_back(c);
+		adjacency_.emplace_back();
+		positions_.push_back(vertices_.size());
+		vertices_.push_back(v);
+		return v;
+	};
+	auto remove = [&] (vertex v) noexcept {
+		assert(adjacency_[v].empty());
+		auto pos = positions_[v];
+		auto last = vertices_.back();
+		vertices_[pos] = last;
+		positions_[last] = pos;
+		vertices_.pop_back();
+	};
+	auto new_color = [&] (cv::Point p) noexcept -> const Color & {
+		if (indices.type() == CV_8UC1) return palette[indices.ptr<std::uint8_t>(p.y)[p.x]];
+		return palette[indices.ptr<int>(p.y)[p.x]];
+	};
+	//	1. Resolve the owner of every pixel so that labels
+	//	identify live vertices directly, and find the pixels
+	//	whose color has changed
+	if (captured_) {
+		labels_ = labels_.clone();
+		captured_ = false;
+	}
+	auto owners = this->owners();
+	std::vector<cv::Point> changed;
+	std::vector<vertex> previous;
+	for (int i = 0; i < rows; ++i) {
+		auto row = labels_.ptr<int>(i);
+		for (int j = 0; j < cols; ++j) {
+			auto v = owners[row[j]];
+			row[j] = v;
+			if (colors_[v] == new_color(cv::Point(j,i))) continue;
+			changed.emplace_back(j,i);
+			previous.push_back(v);
+		}
+	}
+	//	2. Remove each changed pixel from its vertex.  If the
+	//	vertex's pixels around the removed pixel remain
+	//	connected to one another without it then the vertex
+	//	remains connected, otherwise it must be checked
+	//	The ring of neighbors in order, four-neighbors at
+	//	even positions
+	static const cv::Point ring[] = {
+		cv::Point(1,0),cv::Point(1,-1),cv::Point(0,-1),cv::Point(-1,-1),
+		cv::Point(-1,0),cv::Point(-1,1),cv::Point(0,1),cv::Point(1,1)
+	};
+	std::vector<bool> suspect(owners_.size(),false);
+	for (std::size_t k = 0; k < changed.size(); ++k) {
+		auto p = changed[k];
+		auto v = previous[k];
+		bool in[8];
+		bool any = false;
+		for (int r = 0; r < 8; ++r) {
+			auto q = p + ring[r];
+			in[r] = (q.x >= 0) && (q.y >= 0) && (q.x < cols) && (q.y < rows) && (at(q) == v);
+			//	Pixels diagonal to the removed pixel are not its
+			//	neighbors without diagonal connectivity
+			if (Neighborhood::diagonal || ((r % 2) == 0)) any = any || in[r];
+		}
+		bool joined[8];
+		for (int r = 0; r < 8; ++r) {
+			joined[r] = in[r] || (Neighborhood::diagonal && ((r % 2) != 0) && in[r - 1] && in[(r + 1) % 8]);
+		}
+		//	Counts the runs around the ring which contain a
+		//	neighbor of the removed pixel
+		int runs = 0;
+		if (any) {
+			auto start = int(std::find(joined,joined + 8,false) - joined);
+			if (start == 8) {
+				runs = 1;
+			} else {
+				bool counted = false;
+				for (int r = 1; r <= 8; ++r) {
+					auto curr = (start + r) % 8;
+					if (!joined[curr]) {
+						counted = false;
+						continue;
+					}
+					if (counted) continue;
+					if (in[curr] && (Neighborhood::diagonal || ((curr % 2) == 0))) {
+						++runs;
+						counted = true;
+					}
+				}
+			}
+		}
+		if (runs > 1) suspect[v] = true;
+		move(p,v,unowned,identity);
+		at(p) = unowned;
+	}
+	//	3. Split suspect vertices which are no longer connected.
+	//	Every part of such a vertex neighbors a removed pixel
+	std::vector<span> stack;
+	for (std::size_t k = 0; k < changed.size(); ++k) {
+		auto v = previous[k];
+		if (!suspect[v]) continue;
+		suspect[v] = false;
+		if (sizes_[v] == 0) continue;
+		std::vector<cv::Point> seeds;
+		for (std::size_t l = k; l < changed.size(); ++l) {
+			if (previous[l] != v) continue;
+			visit(changed[l],[&] (cv::Point q) {
+				if (at(q) == v) seeds.push_back(q);
+			});
+		}
+		assert(!seeds.empty());
+		auto is_v = [&] (cv::Point q) noexcept {	return at(q) == v;	};
+		auto first = seeds.front();
+		auto found = scanline_flood_fill<Neighborhood>(labels_,first,is_v,labels_,pending,stack);
+		if (found != sizes_[v]) {
+			auto owner = [&] (int label) noexcept {	return (label == pending) ? v : label;	};
+			for (auto seed : seeds) {
+				if (at(seed) != v) continue;
+				auto part = add(colors_[v]);
+				scanline_flood_fill<Neighborhood>(labels_,seed,[&] (cv::Point q) {
+					if (at(q) != v) return false;
+					move(q,v,part,owner);
+					return true;
+				},labels_,part,stack);
+			}
+		}
+		scanline_flood_fill<Neighborhood>(labels_,first,[&] (cv::Point q) noexcept {	return at(q) == pending;	},labels_,v,stack);
+	}
+	for (std::size_t k = 0; k < changed.size(); ++k) {
+		auto v = previous[k];
+		if ((sizes_[v] == 0) && (positions_[v] < vertices_.size()) && (vertices_[positions_[v]] == v)) remove(v);
+	}
+	//	4. Add each connected group of changed pixels of the
+	//	same color as a new vertex
+	for (auto p : changed) {
+		if (at(p) != unowned) continue;
+		auto c = new_color(p);
+		auto v = add(c);
+		scanline_flood_fill<Neighborhood>(labels_,p,[&] (cv::Point q) {
+			if ((at(q) != unowned) || !(new_color(q) == c)) return false;
+			move(q,unowned,v,identity);
+			return true;
+		},labels_,v,stack);
+	}
+	//	5. Regions are connected pixels of the same color so
+	//	neighboring vertices of the same color are merged
+	std::vector<vertex> curr(vertices_);
+	std::vector<bool> merged(owners_.size(),false);
+	std::vector<vertex> same;
+	for (auto v : curr) {
+		if (merged[v]) continue;
+		for (;;) {
+			same.clear();
+			for (auto && e : adjacency_[v]) if (colors_[e.to] == colors_[v]) same.push_back(e.to);
+			if (same.empty()) break;
+			for (auto u : same) {
+				merge(v,u,false);
+				merged[u] = true;
+			}
+		}
+	}
+	//	6. Every pixel of each vertex now has the color of the
+	//	vertex, as though the graph had been built afresh
+	for (auto v : vertices_) {
+		sums_[v] = cv::Vec3d(colors_[v][0],colors_[v][1],colors_[v][2]) * double(sizes_[v]);
+		auto from = traits::to_lab(colors_[v]);
+		for (auto && e : adjacency_[v]) {
+			e.gradient = double(e.border) * std::sqrt(double(squared_distance(from,traits::to_lab(colors_[e.to]))));
+		}
+	}
+	//	7. Vertex ids are a mixture of old ids and ids of new
+	//	vertices, which would differ from a graph built afresh
+	renumber();
+}
+
+template <typename Color>
+void region_graph<Color>::renumber () {
+	//	Vertices are numbered in raster order of their first
+	//	pixels as label_equal_components numbers regions
+	auto owners = this->owners();
+	std::vector<vertex> ids(owners_.size(),-1);
+	int n = 0;
+	for (int i = 0; i < labels_.rows; ++i) {
+		auto row = labels_.ptr<int>(i);
+		for (int j = 0; j < labels_.cols; ++j) {
+			auto && id = ids[owners[row[j]]];
+			if (id == -1) id = n++;
+			row[j] = id;
+		}
+	}
+	assert(std::size_t(n) == vertices_.size());
+	std::vector<std::size_t> sizes(n);
+	std::vector<cv::Vec3d> sums(n);
+	std::vector<Color> colors(n);
+	std::vector<adjacency_list> adjacency(n);
+	for (auto v : vertices_) {
+		auto id = ids[v];
+		sizes[id] = sizes_[v];
+		sums[id] = sums_[v];
+		colors[id] = colors_[v];
+		auto && list = adjacency[id];
+		list = std::move(adjacency_[v]);
+		for (auto && e : list) e.to = ids[e.to];
+		std::sort(list.begin(),list.end(),[] (const edge & a, const edge & b) noexcept {
+			return a.to < b.to;
+		});
+	}
+	sets_ = sized_union_find(n);
+	owners_.resize(n);
+	vertices_.resize(n);
+	positions_.resize(n);
+	for (int v = 0; v < n; ++v) {
+		owners_[v] = v;
+		vertices_[v] = v;
+		positions_[v] = std::size_t(v);
+	}
+	sizes_.swap(sizes);
+	sums_.swap(sums);
+	colors_.swap(colors);
+	adjacency_.swap(adjacency);
+}
+
+template <typename Color>
+std::vector<typename region_graph<Color>::vertex> region_graph<Color>::owners () const {
+	std::vector<vertex> retr(owners_.size());
+	for (std::size_t v = 0; v < retr.size(); ++v) retr[v] = owners_[sets_.find(int(v))];
+	return retr;
+}
+
+template <typename Color>
+cv::Mat region_graph<Color>::mat () const {
+	std::vector<Color> colors;
+	colors.reserve(owners_.size());
+	for (auto v : owners()) colors.push_back(colors_[v]);
+	cv::Mat retr(labels_.rows,labels_.cols,traits::type);
+	parallel_rows(retr,[&] (int i) noexcept {
+		auto in = labels_.ptr<int>(i);
+		auto out = retr.ptr<Color>(i);
+		for (int j = 0; j < retr.cols; ++j) out[j] = colors[in[j]];
+	});
+	return retr;
+}
+
+template <typename Color>
+cv::Mat region_graph<Color>::labels (std::vector<Color> & palette) const {
+	palette.clear();
+	palette.reserve(size());
+	std::vector<int> compact(colors_.size(),-1);
+	for (auto v : vertices_) {
+		compact[v] = int(palette.size());
+		palette.push_back(colors_[v]);
+	}
+	auto owners = this->owners();
+	for (auto && v : owners) v = compact[v];
+	cv::Mat retr(labels_.rows,labels_.cols,CV_32SC1);
+	parallel_rows(retr,[&] (int i) noexcept {
+		auto in = labels_.ptr<int>(i);
+		auto out = retr.ptr<int>(i);
+		for (int j = 0; j < retr.cols; ++j) out[j] = owners[in[j]];
+	});
+	return retr;
+}
+
+template <typename Color>
+cv::Mat region_graph<Color>::capture (std::vector<Color> & palette) {
+	//	Rather than relabeling every pixel the labels are
+	//	shared and the palette has an entry for every vertex
+	//	which has ever existed
+	palette.clear();
+	palette.reserve(owners_.size());
+	for (auto v : owners()) palette.push_back(colors_[v]);
+	captured_ = true;
+	return labels_;
+}
+
+/**
+ *	Merges each region at or below a certain size into
+ *	its largest neighbor (the neighbor with which it
+ *	shares the longest border if several are largest),
+ *	smallest regions first, until no region is at or
+ *	below that size.
+ *
+ *	\tparam Color
+ *		The type of each color.
+ *
+ *	\param [in] g
+ *		The graph.
+ *	\param [in] threshold
+ *		The size (in pixels) at or below which a region
+ *		is merged.
+ *	\param [in] avg
+ *		If \em true the region into which each region is
+ *		merged is recolored with the mean color of both,
+ *		otherwise it keeps its color so that no new colors
+ *		are introduced.  Defaults to \em true.
+ */
+template <typename Color>
+void merge_small_cells (region_graph<Color> & g, std::size_t threshold, bool avg = true) {
+	//	The criterion for choosing which neighbor to merge
+	//	a small cell into is implemented by Sp3000 as:
+	//
+	//	closest_cell = max(neighbour_cells, key=neighbour_cells.count)
+	//
+	//	We choose the largest neighbor in the same way, and
+	//	since many neighbors of a small cell are often of the
+	//	same size ties are broken by the length of the shared
+	//	border rather than arbitrarily
+	//
+	//	Small cells are placed in buckets by size and merged
+	//	smallest first.  Once all cells of a certain size have
+	//	been merged every remaining cell is larger, so merging
+	//	a cell always grows a cell into a later bucket (if
+	//	any), and cells only ever need to be revisited when
+	//	they grow
+	using vertex = typename region_graph<Color>::vertex;
+	std::vector<std::vector<vertex>> buckets(threshold + 1U);
+	for (auto v : g.vertices()) if (g.size(v) < buckets.size()) buckets[g.size(v)].push_back(v);
+	for (std::size_t size = 1; size < buckets.size(); ++size) {
+		for (auto curr : buckets[size]) {
+			//	Cells only ever grow, so a cell which is no
+			//	longer this size has been merged into and is
+			//	in a later bucket
+			if (g.size(curr) != size) continue;
+			auto && ns = g.neighbors(curr);
+			auto iter = std::max_element(ns.begin(),ns.end(),[&] (auto && a, auto && b) noexcept {
+				if (g.size(a.to) != g.size(b.to)) return g.size(a.to) < g.size(b.to);
+				return a.border < b.border;
+			});
+			if (iter == ns.end()) throw std::logic_error("Small cell with no neighbors");
+			auto into = iter->to;
+			g.merge(into,curr,avg);
+			assert(g.size(into) > size);
+			if (g.size(into) < buckets.size()) buckets[g.size(into)].push_back(into);
+		}
+		std::vector<vertex>().swap(buckets[size]);
+	}
+}
+
+/**
+ *	Merges neighboring regions of similar colors until no
+ *	two neighboring regions have similar colors.
+ *
+ *	\tparam Color
+ *		The type of each color.
+ *
+ *	\param [in] g
+ *		The graph.
+ *	\param [in] tolerance
+ *		Neighboring regions are merged if the squared
+ *		distance in CIELAB between their colors is less
+ *		than this value.
+ */
+template <typename Color>
+void merge_similar_cells (region_graph<Color> & g, float tolerance) {
+	//	Each cell absorbs all neighbors whose color is within
+	//	the tolerance of its own.  Absorbing a neighbor changes
+	//	a cell's color and neighbors, so the cell is queued to
+	//	be examined again, whereas no other pair of neighboring
+	//	cells changes.  Once the queue is empty therefore no two
+	//	neighboring cells are within the tolerance of one another.
+	//	Absorbed cells are flagged and skipped when dequeued.
+	//
+	//	Cells are initially examined from largest to smallest
+	using vertex = typename region_graph<Color>::vertex;
+	if (g.size() == 0) return;
+	auto && vertices = g.vertices();
+	std::vector<vertex> sorted(vertices.begin(),vertices.end());
+	std::sort(sorted.begin(),sorted.end(),[&] (auto a, auto b) noexcept {
+		if (g.size(a) != g.size(b)) return g.size(a) > g.size(b);
+		return a > b;
+	});
+	std::size_t ids = *std::max_element(sorted.begin(),sorted.end()) + 1U;
+	std::deque<vertex> queue(sorted.begin(),sorted.end());
+	std::vector<bool> merged(ids,false);
+	std::vector<vertex> to_merge;
+	auto squared_tolerance = lab_traits<Color>::from_squared_distance(tolerance);
+	while (!queue.empty()) {
+		auto curr = queue.front();
+		queue.pop_front();
+		if (merged[curr]) continue;
+		auto color = g.color(curr);
+		to_merge.clear();
+		for (auto && e : g.neighbors(curr)) {
+			if (squared_distance(g.color(e.to),color) < squared_tolerance) to_merge.push_back(e.to);
+		}
+		if (to_merge.empty()) continue;
+		for (auto n : to_merge) {
+			g.merge(curr,n);
+			merged[n] = true;
+		}
+		queue.push_back(curr);
+	}
+}
+
+/**
+ *	Repeatedly merges the pair of neighboring regions for
+ *	which the squared distance between their colors
+ *	multiplied by the size of the larger is least until
+ *	no more than a certain number of regions remain.
+ *	Ties are broken by the smaller and then the larger
+ *	vertex id.
+ *
+ *	\tparam Color
+ *		The type of each color.
+ *
+ *	\param [in] g
+ *		The graph.
+ *	\param [in] n
+ *		The number of regions.
+ *	\param [in] avg
+ *		If \em true each merged region is recolored with
+ *		the mean color of both regions, otherwise it takes
+ *		the color of the larger (or if they are the same
+ *		size the first) so that no new colors are
+ *		introduced.  Defaults to \em true.
+ */
+template <typename Color>
+void n_merge (region_graph<Color> & g, std::size_t n, bool avg = true) {
+	using vertex = typename region_graph<Color>::vertex;
+	//	Rather than finding the optimal pair of neighbors by
+	//	examining every edge after each merge every edge is
+	//	placed in a priority queue.  Merging changes the weight
+	//	of every edge incident on the merged vertices, so each
+	//	vertex has a version which is incremented when it is
+	//	merged, and edges recorded against a previous version
+	//	are discarded when they reach the top of the queue
+	class candidate {
+	public:
+		float weight;
+		vertex a;
+		vertex b;
+		unsigned a_version;
+		unsigned b_version;
+		bool operator < (const candidate & rhs) const noexcept {
+			//	std::priority_queue is a max heap, ties are
+			//	broken by vertex ids so that the order in which
+			//	merges occur does not depend on the order in
+			//	which edges were inserted
+			if (weight != rhs.weight) return weight > rhs.weight;
+			if (a != rhs.a) return a > rhs.a;
+			return b > rhs.b;
+		}
+	};
+	if (g.size() <= n) return;
+	auto && vertices = g.vertices();
+	std::vector<unsigned> versions(*std::max_element(vertices.begin(),vertices.end()) + 1,0);
+	std::vector<candidate> storage;
+	auto make_edge = [&] (vertex a, vertex b) noexcept {
+		if (b < a) std::swap(a,b);
+		return candidate{detail::n_merge_weight(g,std::make_pair(a,b)),a,b,versions[a],versions[b]};
+	};
+	for (auto v : vertices) for (auto && e : g.neighbors(v)) if (v < e.to) storage.push_back(make_edge(v,e.to));
+	std::priority_queue<candidate> queue(std::less<candidate>(),std::move(storage));
+	while ((g.size() > n) && !queue.empty()) {
+		auto e = queue.top();
+		queue.pop();
+		if ((e.a_version != versions[e.a]) || (e.b_version != versions[e.b])) continue;
+		auto color = (g.size(e.a) < g.size(e.b)) ? g.color(e.b) : g.color(e.a);
+		g.merge(e.a,e.b,avg);
+		if (!avg) g.color(e.a,color);
+		++versions[e.a];
+		++versions[e.b];
+		for (auto && u : g.neighbors(e.a)) queue.push(make_edge(e.a,u.to));
+	}
+}
+
+}
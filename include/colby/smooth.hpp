@@ -0,0 +1,185 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include "lab.hpp"
+#include "parallel.hpp"
+#include <opencv2/core.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <opencv2/core/types.hpp>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace colby {
+
+namespace detail {
+
+//	Maps a coordinate outside [0,n) back into it by
+//	reflection without repeating the edge, as does
+//	cv::BORDER_REFLECT_101
+inline int reflect (int i, int n) noexcept {
+	if (n == 1) return 0;
+	while ((i < 0) || (i >= n)) i = (i < 0) ? -i : (2 * (n - 1)) - i;
+	return i;
+}
+
+//	The radii of three box filters whose composition
+//	approximates a Gaussian with a certain standard
+//	deviation (see Kovesi, "Fast Almost-Gaussian Filtering")
+inline std::array<int,3> gaussian_boxes (double sigma) noexcept {
+	constexpr int n = 3;
+	double ideal = std::sqrt(((12 * sigma * sigma) / n) + 1);
+	int lower = int(std::floor(ideal));
+	if ((lower % 2) == 0) --lower;
+	//	The number of boxes of the lower width which brings
+	//	the variance closest to that desired
+	double m = ((12 * sigma * sigma) - (n * lower * lower) - (4 * n * lower) - (3 * n)) / ((-4 * lower) - 4);
+	std::array<int,3> retr;
+	for (int i = 0; i < n; ++i) retr[i] = (i < std::lround(m)) ? (lower / 2) : ((lower / 2) + 1);
+	return retr;
+}
+
+//	Averages each run of 2r + 1 consecutive values,
+//	producing n values from n + 2r values.  Each value
+//	is a contiguous run of width floats (one pixel when
+//	filtering a row, one row when filtering a column) so
+//	that the inner loop is over contiguous memory
+inline void box_filter (const float * in, float * out, int n, int r, int width, float * sum) noexcept {
+	float scale = 1.f / float((2 * r) + 1);
+	std::fill(sum,sum + width,0.f);
+	for (int i = 0; i < (2 * r); ++i) {
+		auto curr = in + (std::size_t(i) * width);
+		for (int k = 0; k < width; ++k) sum[k] += curr[k];
+	}
+	for (int i = 0; i < n; ++i) {
+		auto add = in + (std::size_t(i + (2 * r)) * width);
+		auto dst = out + (std::size_t(i) * width);
+		for (int k = 0; k < width; ++k) {
+			sum[k] += add[k];
+			dst[k] = sum[k] * scale;
+		}
+		auto remove = in + (std::size_t(i) * width);
+		for (int k = 0; k < width; ++k) sum[k] -= remove[k];
+	}
+}
+
+}
+
+/**
+ *	Smooths an image represented by a label map and
+ *	palette while confining each pixel to a color
+ *	already nearby.
+ *
+ *	Each pixel is blurred using an approximation of a
+ *	Gaussian kernel and then takes whichever of its own
+ *	color and the colors of its four neighbors is nearest
+ *	the blurred color.  The standard deviation of the
+ *	Gaussian is that cv::GaussianBlur would derive from a
+ *	kernel with the given radius.  It is approximated by
+ *	three successive box filters computed with running sums
+ *	so the cost per pixel does not depend on the radius.
+ *
+ *	The image is divided into horizontal tiles which are
+ *	processed concurrently.  Each tile is blurred and
+ *	snapped in a single pass without materializing the
+ *	image in color.
+ *
+ *	\tparam Color
+ *		The type of each color in the palette.
+ *
+ *	\param [in] labels
+ *		An image of type CV_32SC1 wherein each pixel holds
+ *		the index of its color within \em palette.
+ *	\param [in] palette
+ *		The colors.
+ *	\param [in] radius
+ *		The radius of the Gaussian kernel.  Zero leaves
+ *		the image unchanged.
+ *
+ *	\return
+ *		An image of type CV_32SC1 with the same dimensions
+ *		as \em labels wherein each pixel holds the index
+ *		of its new color within \em palette.
+ */
+template <typename Color>
+cv::Mat smooth_labels (const cv::Mat & labels, const std::vector<Color> & palette, std::size_t radius) {
+	assert(labels.type() == CV_32SC1);
+	if (radius == 0) return labels.clone();
+	auto boxes = detail::gaussian_boxes((0.3 * (double(radius) - 1)) + 0.8);
+	int extent = boxes[0] + boxes[1] + boxes[2];
+	std::vector<cv::Vec3f> lab;
+	lab.reserve(palette.size());
+	for (auto && c : palette) lab.push_back(lab_traits<Color>::to_lab(c));
+	cv::Mat retr(labels.rows,labels.cols,CV_32SC1);
+	int cols = labels.cols;
+	int width = cols * 3;
+	parallel_for(cv::Range(0,labels.rows),[&] (const cv::Range & range) {
+		//	The image is extended by reflection before being
+		//	filtered and each filter consumes its radius from
+		//	either side, so each tile reads extent rows and
+		//	columns beyond its edges
+		int rows = (range.end - range.start) + (2 * extent);
+		std::vector<cv::Vec3f> a(std::size_t(rows) * cols);
+		std::vector<cv::Vec3f> b(a.size());
+		std::vector<cv::Vec3f> padded(std::size_t(cols) + (2 * extent));
+		std::vector<cv::Vec3f> scratch(padded.size());
+		std::vector<float> sum(std::size_t(std::max(3,width)));
+		for (int r = 0; r < rows; ++r) {
+			auto in = labels.ptr<int>(detail::reflect(range.start - extent + r,labels.rows));
+			for (int j = 0; j < int(padded.size()); ++j) padded[j] = lab[in[detail::reflect(j - extent,cols)]];
+			int n = int(padded.size());
+			auto src = padded.data();
+			auto dst = scratch.data();
+			for (auto box : boxes) {
+				n -= 2 * box;
+				detail::box_filter(src[0].val,dst[0].val,n,box,3,sum.data());
+				std::swap(src,dst);
+			}
+			std::copy(src,src + cols,a.data() + (std::size_t(r) * cols));
+		}
+		int n = rows;
+		auto src = a.data();
+		auto dst = b.data();
+		for (auto box : boxes) {
+			n -= 2 * box;
+			detail::box_filter(src[0].val,dst[0].val,n,box,width,sum.data());
+			std::swap(src,dst);
+		}
+		for (int i = range.start; i < range.end; ++i) {
+			auto blurred = src + (std::size_t(i - range.start) * cols);
+			auto in = labels.ptr<int>(i);
+			auto above = labels.ptr<int>(std::max(i - 1,0));
+			auto below = labels.ptr<int>(std::min(i + 1,labels.rows - 1));
+			auto out = retr.ptr<int>(i);
+			for (int j = 0; j < cols; ++j) {
+				//	Candidates are considered in the same order
+				//	as by four_neighborhood so ties are broken
+				//	consistently
+				int best = in[j];
+				auto best_dist = squared_distance(lab[best],blurred[j]);
+				auto consider = [&] (int candidate) noexcept {
+					auto d = squared_distance(lab[candidate],blurred[j]);
+					if (d < best_dist) {
+						best = candidate;
+						best_dist = d;
+					}
+				};
+				if (j != 0) consider(in[j - 1]);
+				if ((j + 1) != cols) consider(in[j + 1]);
+				if ((i + 1) != labels.rows) consider(below[j]);
+				if (i != 0) consider(above[j]);
+				out[j] = best;
+			}
+		}
+	});
+	return retr;
+}
+
+}
@@ -5,19 +5,17 @@
 #pragma once
 
 #include "color_by_numbers.hpp"
-#include "optional.hpp"
-#include "hash.hpp"
+#include "lab.hpp"
+#include "region_graph.hpp"
 #include "sp3000_color_by_numbers_observer.hpp"
-#include <boost/iterator/indirect_iterator.hpp>
-#include <boost/range/iterator_range.hpp>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/matx.hpp>
 #include <opencv2/core/types.hpp>
 #include <cstddef>
-#include <deque>
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
-#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace colby {
 
@@ -33,76 +31,154 @@ namespace colby {
  *	color).
  */
 class sp3000_color_by_numbers : public color_by_numbers {
-private:
-	using cell = std::unordered_set<cv::Point>;
-	class graph {
-	public:
-		class vertex {
-		private:
-			cell cell_;
-			using adjacency_list = std::unordered_set<vertex *>;
-			adjacency_list adj_list_;
-			cv::Vec3f color_;
-			graph & owner_;
-		public:
-			explicit vertex (graph &);
-			vertex (const vertex &) = delete;
-			vertex (vertex &&) = delete;
-			vertex & operator = (const vertex &) = delete;
-			vertex & operator = (vertex &&) = delete;
-			void add (cv::Point, cv::Vec3f);
-			void add (vertex &);
-			void merge (vertex &, bool avg = true);
-			using neighbors_type = boost::iterator_range<boost::indirect_iterator<adjacency_list::const_iterator>>;
-			neighbors_type neighbors () const noexcept;
-			std::size_t size () const noexcept;
-			cv::Vec3f color () const noexcept;
-			void color (cv::Vec3f) noexcept;
-			const cell & points () const noexcept;
-		};
-	private:
-		std::deque<vertex> vertices_storage_;
-		using vertices_internal = std::unordered_set<vertex *>;
-		vertices_internal vertices_;
-		std::unordered_map<cv::Point,vertex *> lookup_;
-		int rows_;
-		int cols_;
-		template <typename Iterator>
-		using make_vertices_type = boost::iterator_range<boost::indirect_iterator<Iterator>>;
+public:
+	/**
+	 *	The representations of CIELAB colors which
+	 *	may be used internally.
+	 */
+	enum class lab_format {
+		/**
+		 *	Three 32-bit floating point channels
+		 *	(12 bytes per pixel).
+		 */
+		floating_point,
+		/**
+		 *	Three 16-bit fixed point channels (6 bytes
+		 *	per pixel, see \ref lab2fixed).  Color
+		 *	distances are computed using integer
+		 *	arithmetic.
+		 */
+		fixed_point
+	};
+	/**
+	 *	The sets of pixels considered adjacent to each
+	 *	pixel when dividing images into regions.
+	 */
+	enum class connectivity {
+		/**
+		 *	The four pixels which share an edge.
+		 */
+		four,
+		/**
+		 *	The eight pixels which share an edge or
+		 *	a corner.  Diagonal runs of similar pixels
+		 *	become a single region rather than many
+		 *	tiny regions.
+		 */
+		eight
+	};
+	/**
+	 *	The algorithms which may be used to choose the
+	 *	final colors.
+	 */
+	enum class quantizer {
+		/**
+		 *	Weighted k-means with many attempts (see
+		 *	\ref weighted_kmeans).
+		 */
+		k_means,
+		/**
+		 *	Median cut (see \ref median_cut).  Much
+		 *	cheaper than \ref quantizer::k_means but
+		 *	the colors chosen are usually less
+		 *	representative.
+		 */
+		median_cut
+	};
+	/**
+	 *	Options which control how images are converted
+	 *	beyond the parameters of the original algorithm.
+	 *	Default constructed options behave as that
+	 *	algorithm does.
+	 */
+	class options {
 	public:
-		graph () = delete;
-		graph (const graph &) = delete;
-		graph (graph &&) = delete;
-		graph & operator = (const graph &) = delete;
-		graph & operator = (graph &&) = delete;
-		explicit graph (const cv::Mat &);
-		vertex & add ();
-		vertex * find (cv::Point);
-		using vertices_type = make_vertices_type<vertices_internal::iterator>;
-		vertices_type vertices () noexcept;
-		using const_vertices_type = make_vertices_type<vertices_internal::const_iterator>;
-		const_vertices_type vertices () const noexcept;
-		std::size_t size () const noexcept;
-		using neighbors_type = std::pair<vertex &,vertex &>;
-		template <typename Callback>
-		optional<neighbors_type> optimal_neighbors (Callback);
-		cv::Mat mat () const;
+		/**
+		 *	Creates options with default values.
+		 */
+		options () noexcept;
+		/**
+		 *	The representation of CIELAB colors used
+		 *	internally.  \ref lab_format::fixed_point
+		 *	halves the memory occupied by each image at
+		 *	the cost of rounding each channel to the
+		 *	nearest multiple of \f$2^{-6}\f$.  Defaults
+		 *	to \ref lab_format::floating_point.
+		 */
+		lab_format format;
+		/**
+		 *	The number of horizontal strips into which
+		 *	images are divided so that they may be
+		 *	segmented concurrently (see
+		 *	\ref parallel_label_components).  Zero selects
+		 *	the number of threads used by OpenCV.  Defaults
+		 *	to one, which segments images serially.
+		 */
+		std::size_t strips;
+		/**
+		 *	The pixels considered adjacent to each pixel
+		 *	when images are divided into regions.
+		 *	Defaults to \ref connectivity::four.
+		 */
+		connectivity neighborhood;
+		/**
+		 *	The seed for the random choices made when
+		 *	choosing the final colors.  The same image
+		 *	converted with the same seed always yields
+		 *	the same result.  Defaults to zero.
+		 */
+		std::uint64_t seed;
+		/**
+		 *	The algorithm used to choose the final colors.
+		 *	Defaults to \ref quantizer::k_means.
+		 */
+		quantizer palette;
+		/**
+		 *	The radius of the Gaussian kernel used to smooth
+		 *	the edges of regions before they are divided a
+		 *	second time (see \ref smooth_labels).  Larger
+		 *	radii yield larger regions which are easier to
+		 *	paint at no additional cost.  Zero disables
+		 *	smoothing.  Defaults to 3.
+		 */
+		std::size_t smoothing_radius;
+		/**
+		 *	If \em true after smoothing the regions are
+		 *	found by updating the existing regions where
+		 *	pixels changed color rather than by dividing
+		 *	the whole image again.  The result is the same
+		 *	but the work done is proportional to the number
+		 *	of pixels which changed rather than the area of
+		 *	the image, except where a region may have been
+		 *	split.  Defaults to \em false.
+		 */
+		bool incremental;
 	};
+private:
+	template <typename Color>
+	using graph = region_graph<Color>;
 	float flood_fill_tolerance_;
 	std::size_t small_cell_threshold_;
 	float similar_cell_tolerance_;
 	std::size_t max_final_cells_;
 	std::size_t max_final_colors_;
+	options options_;
 	sp3000_color_by_numbers_observer * o_;
-	static cell image_as_cell (const cv::Mat &);
-	static void subtract (cell &, const cell &);
-	std::unique_ptr<graph> divide (const cv::Mat &) const;
-	void merge_small_cells_impl (graph &, std::size_t) const;
-	void merge_small_cells (graph &) const;
-	void merge_similar_cells (graph &) const;
-	void n_merge (graph &, std::size_t) const;
-	void p_merge (graph &, std::size_t) const;
-	cv::Mat gaussian_smooth (const graph &, std::size_t) const;
+	template <typename Color>
+	std::unique_ptr<graph<Color>> divide (const cv::Mat &) const;
+	template <typename Color>
+	std::unique_ptr<graph<Color>> divide (const cv::Mat &, const std::vector<Color> &) const;
+	template <typename Color>
+	void redivide (graph<Color> &, const cv::Mat &, const std::vector<Color> &) const;
+	template <typename Color>
+	void p_merge (graph<Color> &, std::size_t) const;
+	template <typename Color>
+	cv::Mat gaussian_smooth (const graph<Color> &, std::size_t, std::vector<Color> &) const;
+	template <typename Color>
+	static cv::Mat render (const cv::Mat &, const std::vector<Color> &);
+	template <typename Color>
+	static cv::Mat render (const graph<Color> &);
+	template <typename Color>
 	result convert_impl (const cv::Mat & src);
 public:
 	sp3000_color_by_numbers () = delete;
@@ -137,13 +213,17 @@ public:
 	 *		coordinates.  All distances less than this
 	 *		value shall result in the neighboring cells
 	 *		being merged.  Defaults to a sensible value.
+	 *	\param [in] opts
+	 *		Further options (see \ref options).  Defaults
+	 *		to default constructed options.
 	 */
 	sp3000_color_by_numbers (
 		std::size_t max_final_cells,
 		std::size_t max_final_colors,
 		float flood_fill_tolerance = 10.f,
 		std::size_t small_cell_threshold = 10,
-		float similar_cell_tolerance = 5.f
+		float similar_cell_tolerance = 5.f,
+		options opts = options()
 	);
 	/**
 	 *	Creates a new sp3000_color_by_numbers.
@@ -182,6 +262,9 @@ public:
 	 *		coordinates.  All distances less than this
 	 *		value shall result in the neighboring cells
 	 *		being merged.  Defaults to a sensible value.
+	 *	\param [in] opts
+	 *		Further options (see \ref options).  Defaults
+	 *		to default constructed options.
 	 */
 	sp3000_color_by_numbers (
 		sp3000_color_by_numbers_observer & o,
@@ -189,7 +272,8 @@ public:
 		std::size_t max_final_colors,
 		float flood_fill_tolerance = 10.f,
 		std::size_t small_cell_threshold = 10,
-		float similar_cell_tolerance = 5.f
+		float similar_cell_tolerance = 5.f,
+		options opts = options()
 	);
 	virtual result convert (const cv::Mat & src) override;
 };
@@ -5,7 +5,10 @@
 #pragma once
 
 #include "image_factory.hpp"
+#include "timer.hpp"
 #include <opencv2/core/mat.hpp>
+#include <cstddef>
+#include <memory>
 
 namespace colby {
 
@@ -25,20 +28,75 @@ public:
 	 *	up through pointer or reference to base.
 	 */
 	virtual ~sp3000_color_by_numbers_observer () noexcept;
+	/**
+	 *	Describes a single stage of the algorithm.
+	 *
+	 *	Every member is gathered as the algorithm
+	 *	runs so obtaining these statistics does not
+	 *	require the image to be rendered.
+	 */
+	class stage_statistics {
+	public:
+		/**
+		 *	The number of regions once the stage is
+		 *	complete.  For the Gaussian smooth event
+		 *	this is the number of regions before the
+		 *	smoothed image is divided anew.
+		 */
+		std::size_t regions;
+		/**
+		 *	The number of times two regions were
+		 *	merged during the stage.
+		 */
+		std::size_t merges;
+		/**
+		 *	The number of pixels the stage read from
+		 *	an image.  Stages which operate only on
+		 *	regions visit no pixels.
+		 */
+		std::size_t pixels;
+		/**
+		 *	The wall clock time taken by the stage,
+		 *	not including the time taken by the
+		 *	observer to handle earlier events.
+		 */
+		timer::duration elapsed;
+		/**
+		 *	The peak resident set size of the process
+		 *	in bytes when the stage completed, or zero
+		 *	if it cannot be determined on this platform.
+		 */
+		std::size_t peak_memory;
+	};
 	/**
 	 *	A base class for events from
 	 *	\ref sp3000_color_by_numbers objects.
 	 */
 	class base_event {
 	private:
-		image_factory & factory_;
+		//	Set only if the event owns its factory (i.e.
+		//	it is a snapshot)
+		std::shared_ptr<image_factory> owned_;
+		image_factory * factory_;
+		stage_statistics statistics_;
 	public:
 		base_event () = delete;
 		base_event (const base_event &) = default;
 		base_event (base_event &&) = default;
 		base_event & operator = (const base_event &) = default;
 		base_event & operator = (base_event &&) = default;
-		explicit base_event (image_factory &) noexcept;
+		base_event (image_factory &, const stage_statistics &) noexcept;
+		base_event (std::shared_ptr<image_factory>, const stage_statistics &) noexcept;
+		/**
+		 *	Retrieves statistics about the stage which
+		 *	just completed.  Unlike \ref image this
+		 *	is cheap.
+		 *
+		 *	\return
+		 *		A reference to a \ref stage_statistics
+		 *		object.
+		 */
+		const stage_statistics & statistics () const noexcept;
 		/**
 		 *	Retrieves the image associated with the
 		 *	event.
@@ -47,6 +105,22 @@ public:
 		 *		A cv::Mat.
 		 */
 		cv::Mat image () const;
+		/**
+		 *	Captures the state from which the image
+		 *	associated with the event is produced.
+		 *
+		 *	The event passed to an observer is only
+		 *	valid for the duration of the call since
+		 *	the state from which its image is produced
+		 *	continues to change.  The copy returned by
+		 *	this method remains valid indefinitely and
+		 *	its image is that which this event would
+		 *	have produced at the time of the call.
+		 *
+		 *	\return
+		 *		A base_event.
+		 */
+		base_event snapshot () const;
 	};
 	/**
 	 *	Encapsulates all information about the
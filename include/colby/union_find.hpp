@@ -0,0 +1,311 @@
+/**
+ *	\file
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace colby {
+
+/**
+ *	A disjoint set forest over the integers
+ *	\f$[0,n)\f$.
+ *
+ *	The representative of each set is always its
+ *	smallest element, so the representative of a
+ *	set does not depend on the order in which sets
+ *	are united.  It follows that the parent of each
+ *	element is never greater than the element.
+ *
+ *	Sets are not united by rank or size, so finding
+ *	a representative takes amortized logarithmic
+ *	rather than near constant time.  Where the choice
+ *	of representative does not matter use
+ *	\ref sized_union_find.
+ */
+class union_find {
+private:
+	std::vector<int> parents_;
+public:
+	union_find () = default;
+	union_find (const union_find &) = default;
+	union_find (union_find &&) = default;
+	union_find & operator = (const union_find &) = default;
+	union_find & operator = (union_find &&) = default;
+	/**
+	 *	Creates a new union_find containing a number
+	 *	of singleton sets.
+	 *
+	 *	\param [in] size
+	 *		The number of sets.
+	 */
+	explicit union_find (std::size_t size) {
+		parents_.reserve(size);
+		for (std::size_t i = 0; i < size; ++i) add();
+	}
+	/**
+	 *	Adds a new singleton set.
+	 *
+	 *	\return
+	 *		The sole element of the new set.
+	 */
+	int add () {
+		int retr(parents_.size());
+		parents_.push_back(retr);
+		return retr;
+	}
+	/**
+	 *	Finds the representative of the set containing
+	 *	a certain element.
+	 *
+	 *	\param [in] i
+	 *		The element.
+	 *
+	 *	\return
+	 *		The representative.
+	 */
+	int find (int i) noexcept {
+		//	Path halving
+		while (parents_[i] != i) {
+			parents_[i] = parents_[parents_[i]];
+			i = parents_[i];
+		}
+		return i;
+	}
+	/**
+	 *	Finds the representative of the set containing
+	 *	a certain element without compressing the path
+	 *	thereto.
+	 *
+	 *	\param [in] i
+	 *		The element.
+	 *
+	 *	\return
+	 *		The representative.
+	 */
+	int find (int i) const noexcept {
+		while (parents_[i] != i) i = parents_[i];
+		return i;
+	}
+	/**
+	 *	Unites the sets containing two elements.
+	 *
+	 *	\param [in] a
+	 *		An element.
+	 *	\param [in] b
+	 *		An element.
+	 *
+	 *	\return
+	 *		The representative of the united set.
+	 */
+	int unite (int a, int b) noexcept {
+		a = find(a);
+		b = find(b);
+		if (b < a) std::swap(a,b);
+		parents_[b] = a;
+		return a;
+	}
+	/**
+	 *	Determines the number of elements.
+	 *
+	 *	\return
+	 *		The number of elements.
+	 */
+	std::size_t size () const noexcept {
+		return parents_.size();
+	}
+};
+
+/**
+ *	A disjoint set forest over the integers
+ *	\f$[0,n)\f$ wherein the smaller of two sets is
+ *	always linked under the larger.
+ *
+ *	Together with path halving this means that
+ *	finding a representative takes amortized
+ *	\f$O(\alpha(n))\f$ time, however unlike
+ *	\ref union_find which element represents each
+ *	set depends on the order in which sets are
+ *	united.
+ */
+class sized_union_find {
+private:
+	std::vector<int> parents_;
+	std::vector<std::size_t> sizes_;
+public:
+	sized_union_find () = default;
+	sized_union_find (const sized_union_find &) = default;
+	sized_union_find (sized_union_find &&) = default;
+	sized_union_find & operator = (const sized_union_find &) = default;
+	sized_union_find & operator = (sized_union_find &&) = default;
+	/**
+	 *	Creates a new sized_union_find containing a
+	 *	number of singleton sets.
+	 *
+	 *	\param [in] size
+	 *		The number of sets.
+	 */
+	explicit sized_union_find (std::size_t size) {
+		parents_.reserve(size);
+		sizes_.reserve(size);
+		for (std::size_t i = 0; i < size; ++i) add();
+	}
+	/**
+	 *	Adds a new singleton set.
+	 *
+	 *	\return
+	 *		The sole element of the new set.
+	 */
+	int add () {
+		int retr(parents_.size());
+		parents_.push_back(retr);
+		sizes_.push_back(1);
+		return retr;
+	}
+	/**
+	 *	Finds the representative of the set containing
+	 *	a certain element.
+	 *
+	 *	\param [in] i
+	 *		The element.
+	 *
+	 *	\return
+	 *		The representative.
+	 */
+	int find (int i) noexcept {
+		//	Path halving
+		while (parents_[i] != i) {
+			parents_[i] = parents_[parents_[i]];
+			i = parents_[i];
+		}
+		return i;
+	}
+	/**
+	 *	Unites the sets containing two elements.
+	 *
+	 *	\param [in] a
+	 *		An element.
+	 *	\param [in] b
+	 *		An element.
+	 *
+	 *	\return
+	 *		The representative of the united set.
+	 */
+	int unite (int a, int b) noexcept {
+		a = find(a);
+		b = find(b);
+		if (a == b) return a;
+		if (sizes_[a] < sizes_[b]) std::swap(a,b);
+		parents_[b] = a;
+		sizes_[a] += sizes_[b];
+		return a;
+	}
+	/**
+	 *	Determines the number of elements.
+	 *
+	 *	\return
+	 *		The number of elements.
+	 */
+	std::size_t size () const noexcept {
+		return parents_.size();
+	}
+};
+
+/**
+ *	A disjoint set forest over the integers
+ *	\f$[0,n)\f$ which may be searched and modified
+ *	by multiple threads concurrently without locking.
+ *
+ *	As with \ref union_find the representative of each
+ *	set is always its smallest element, so once all
+ *	threads have finished the partition and the
+ *	representatives do not depend on the order in
+ *	which sets were united.
+ */
+class concurrent_union_find {
+private:
+	std::unique_ptr<std::atomic<int> []> parents_;
+	std::size_t size_;
+public:
+	concurrent_union_find () = delete;
+	concurrent_union_find (const concurrent_union_find &) = delete;
+	concurrent_union_find (concurrent_union_find &&) = default;
+	concurrent_union_find & operator = (const concurrent_union_find &) = delete;
+	concurrent_union_find & operator = (concurrent_union_find &&) = default;
+	/**
+	 *	Creates a new concurrent_union_find containing
+	 *	a number of singleton sets.
+	 *
+	 *	\param [in] size
+	 *		The number of sets.
+	 */
+	explicit concurrent_union_find (std::size_t size)
+		:	parents_(new std::atomic<int> [size]),
+			size_(size)
+	{
+		for (std::size_t i = 0; i < size; ++i) parents_[i].store(int(i),std::memory_order_relaxed);
+	}
+	/**
+	 *	Finds the representative of the set containing
+	 *	a certain element.
+	 *
+	 *	If other threads are concurrently uniting sets
+	 *	the result may be out of date by the time it
+	 *	is returned.
+	 *
+	 *	\param [in] i
+	 *		The element.
+	 *
+	 *	\return
+	 *		The representative.
+	 */
+	int find (int i) noexcept {
+		for (;;) {
+			auto p = parents_[i].load(std::memory_order_relaxed);
+			if (p == i) return i;
+			auto gp = parents_[p].load(std::memory_order_relaxed);
+			//	Path halving: since parents never exceed their
+			//	children this can never introduce a cycle, and
+			//	failure simply means another thread got there
+			//	first
+			if (p != gp) parents_[i].compare_exchange_weak(p,gp,std::memory_order_relaxed);
+			i = gp;
+		}
+	}
+	/**
+	 *	Unites the sets containing two elements.
+	 *
+	 *	\param [in] a
+	 *		An element.
+	 *	\param [in] b
+	 *		An element.
+	 */
+	void unite (int a, int b) noexcept {
+		for (;;) {
+			a = find(a);
+			b = find(b);
+			if (a == b) return;
+			if (b < a) std::swap(a,b);
+			//	Only a representative may be linked, if b has
+			//	been linked by another thread in the meantime
+			//	try again
+			if (parents_[b].compare_exchange_strong(b,a,std::memory_order_relaxed)) return;
+		}
+	}
+	/**
+	 *	Determines the number of elements.
+	 *
+	 *	\return
+	 *		The number of elements.
+	 */
+	std::size_t size () const noexcept {
+		return size_;
+	}
+};
+
+}
@@ -0,0 +1,107 @@
+#include <colby/async_sp3000_color_by_numbers_observer.hpp>
+#include <colby/sp3000_color_by_numbers_observer.hpp>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace colby {
+
+void async_sp3000_color_by_numbers_observer::consume () {
+	std::unique_lock<std::mutex> l(m_);
+	for (;;) {
+		produced_.wait(l,[&] () noexcept {	return done_ || !queue_.empty();	});
+		//	Outstanding events are delivered before stopping
+		if (queue_.empty()) return;
+		std::exception_ptr ex;
+		{
+			auto item = std::move(queue_.front());
+			queue_.pop_front();
+			++delivering_;
+			l.unlock();
+			try {
+				(o_.*item.first)(std::move(item.second));
+			} catch (...) {
+				ex = std::current_exception();
+			}
+		}
+		l.lock();
+		--delivering_;
+		if (ex) {
+			ex_ = ex;
+			queue_.clear();
+		}
+		consumed_.notify_all();
+	}
+}
+
+void async_sp3000_color_by_numbers_observer::enqueue (callback_type callback, const base_event & e) {
+	//	The snapshot must be taken before returning control
+	//	to the algorithm even if the queue is full
+	auto snapshot = e.snapshot();
+	std::unique_lock<std::mutex> l(m_);
+	consumed_.wait(l,[&] () noexcept {	return ex_ || (queue_.size() < capacity_);	});
+	rethrow();
+	queue_.emplace_back(callback,std::move(snapshot));
+	produced_.notify_one();
+}
+
+void async_sp3000_color_by_numbers_observer::rethrow () {
+	if (!ex_) return;
+	auto ex = ex_;
+	ex_ = nullptr;
+	std::rethrow_exception(ex);
+}
+
+async_sp3000_color_by_numbers_observer::async_sp3000_color_by_numbers_observer (sp3000_color_by_numbers_observer & o, std::size_t capacity)
+	:	o_(o),
+		capacity_(capacity),
+		delivering_(0),
+		done_(false)
+{
+	if (capacity_ == 0) throw std::logic_error("Queue capacity must not be zero");
+	t_ = std::thread([this] () {	consume();	});
+}
+
+async_sp3000_color_by_numbers_observer::~async_sp3000_color_by_numbers_observer () noexcept {
+	{
+		std::lock_guard<std::mutex> l(m_);
+		done_ = true;
+	}
+	produced_.notify_one();
+	t_.join();
+}
+
+void async_sp3000_color_by_numbers_observer::flush () {
+	std::unique_lock<std::mutex> l(m_);
+	consumed_.wait(l,[&] () noexcept {	return queue_.empty() && (delivering_ == 0);	});
+	rethrow();
+}
+
+void async_sp3000_color_by_numbers_observer::flood_fill (flood_fill_event e) {
+	enqueue(&sp3000_color_by_numbers_observer::flood_fill,e);
+}
+
+void async_sp3000_color_by_numbers_observer::merge_small_cells (merge_small_cells_event e) {
+	enqueue(&sp3000_color_by_numbers_observer::merge_small_cells,e);
+}
+
+void async_sp3000_color_by_numbers_observer::merge_similar_cells (merge_similar_cells_event e) {
+	enqueue(&sp3000_color_by_numbers_observer::merge_similar_cells,e);
+}
+
+void async_sp3000_color_by_numbers_observer::n_merge (n_merge_event e) {
+	enqueue(&sp3000_color_by_numbers_observer::n_merge,e);
+}
+
+void async_sp3000_color_by_numbers_observer::p_merge (p_merge_event e) {
+	enqueue(&sp3000_color_by_numbers_observer::p_merge,e);
+}
+
+void async_sp3000_color_by_numbers_observer::gaussian_smooth (gaussian_smooth_event e) {
+	enqueue(&sp3000_color_by_numbers_observer::gaussian_smooth,e);
+}
+
+}
@@ -0,0 +1,401 @@
+#include <colby/conversions.hpp>
+#include <colby/lab.hpp>
+#include <colby/parallel.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define COLBY_X86_SIMD
+#include <immintrin.h>
+#define COLBY_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+namespace colby {
+
+namespace {
+
+using bgr2lab_kernel = void (*) (const cv::Vec3b *, cv::Vec3f *, std::size_t);
+using lab2bgr_kernel = void (*) (const cv::Vec3f *, cv::Vec3b *, std::size_t);
+
+//	The number of pixels converted to or from fixed
+//	point CIELAB at a time
+constexpr std::size_t chunk_size = 256;
+
+void bgr2lab_scalar (const cv::Vec3b * in, cv::Vec3f * out, std::size_t n) noexcept {
+	for (std::size_t i = 0; i < n; ++i) out[i] = bgr2lab(in[i]);
+}
+
+void lab2bgr_scalar (const cv::Vec3f * in, cv::Vec3b * out, std::size_t n) noexcept {
+	for (std::size_t i = 0; i < n; ++i) out[i] = lab2bgr(in[i]);
+}
+
+#ifdef COLBY_X86_SIMD
+
+//	The vectorized kernels read the sRGB gamma expansion from
+//	detail::tables() and compute the remaining instances of
+//	pow(x,y) as exp2(y*log2(x)) where:
+//
+//	-	log2 splits x into exponent and mantissa and evaluates
+//		the series 2/ln(2)*atanh(t) for t=(m-1)/(m+1) with
+//		m in [sqrt(1/2),sqrt(2)) (|t| < 0.172 so the truncation
+//		error is below 1e-9)
+//	-	exp2 splits x into the nearest integer and a fraction
+//		in [-1/2,1/2] and evaluates a degree 7 Taylor polynomial
+//		for 2^f (truncation error below 1e-8)
+//
+//	Both are therefore limited by single precision rounding
+//	rather than by the approximations themselves
+constexpr float log2_c1 = 2.8853900817779268f;	//	2/(1ln(2))
+constexpr float log2_c3 = 0.9617966939259756f;	//	2/(3ln(2))
+constexpr float log2_c5 = 0.5770780163555854f;	//	2/(5ln(2))
+constexpr float log2_c7 = 0.4121985831111324f;	//	2/(7ln(2))
+constexpr float log2_c9 = 0.3205988979753252f;	//	2/(9ln(2))
+constexpr float exp2_c1 = 0.6931471805599453f;	//	ln(2)^k/k!
+constexpr float exp2_c2 = 0.2402265069591007f;
+constexpr float exp2_c3 = 0.0555041086648216f;
+constexpr float exp2_c4 = 0.0096181291076285f;
+constexpr float exp2_c5 = 0.0013333558146428f;
+constexpr float exp2_c6 = 0.0001540353039338f;
+constexpr float exp2_c7 = 0.0000152527338040f;
+
+//	SSE2 (part of the x86-64 baseline so always available)
+
+inline __m128 select_ps (__m128 mask, __m128 a, __m128 b) noexcept {
+	return _mm_or_ps(_mm_and_ps(mask,a),_mm_andnot_ps(mask,b));
+}
+
+inline __m128 madd_ps (__m128 a, __m128 b, float c) noexcept {
+	return _mm_add_ps(_mm_mul_ps(a,b),_mm_set1_ps(c));
+}
+
+inline __m128 log2_ps (__m128 x) noexcept {
+	auto bits = _mm_castps_si128(_mm_max_ps(x,_mm_set1_ps(1e-30f)));
+	auto e = _mm_sub_epi32(_mm_srli_epi32(bits,23),_mm_set1_epi32(127));
+	auto m = _mm_castsi128_ps(_mm_or_si128(
+		_mm_and_si128(bits,_mm_set1_epi32(0x007fffff)),
+		_mm_set1_epi32(0x3f800000)
+	));
+	auto big = _mm_cmpgt_ps(m,_mm_set1_ps(1.41421356f));
+	m = select_ps(big,_mm_mul_ps(m,_mm_set1_ps(0.5f)),m);
+	auto ef = _mm_add_ps(_mm_cvtepi32_ps(e),_mm_and_ps(big,_mm_set1_ps(1.f)));
+	auto one = _mm_set1_ps(1.f);
+	auto t = _mm_div_ps(_mm_sub_ps(m,one),_mm_add_ps(m,one));
+	auto t2 = _mm_mul_ps(t,t);
+	auto p = madd_ps(t2,_mm_set1_ps(log2_c9),log2_c7);
+	p = madd_ps(t2,p,log2_c5);
+	p = madd_ps(t2,p,log2_c3);
+	p = madd_ps(t2,p,log2_c1);
+	return _mm_add_ps(ef,_mm_mul_ps(t,p));
+}
+
+inline __m128 exp2_ps (__m128 x) noexcept {
+	x = _mm_min_ps(_mm_max_ps(x,_mm_set1_ps(-126.f)),_mm_set1_ps(126.f));
+	auto n = _mm_cvtps_epi32(x);
+	auto f = _mm_sub_ps(x,_mm_cvtepi32_ps(n));
+	auto p = madd_ps(f,_mm_set1_ps(exp2_c7),exp2_c6);
+	p = madd_ps(f,p,exp2_c5);
+	p = madd_ps(f,p,exp2_c4);
+	p = madd_ps(f,p,exp2_c3);
+	p = madd_ps(f,p,exp2_c2);
+	p = madd_ps(f,p,exp2_c1);
+	p = madd_ps(f,p,1.f);
+	auto scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n,_mm_set1_epi32(127)),23));
+	return _mm_mul_ps(p,scale);
+}
+
+inline __m128 pow_ps (__m128 x, float y) noexcept {
+	return exp2_ps(_mm_mul_ps(log2_ps(x),_mm_set1_ps(y)));
+}
+
+inline __m128 linear2srgb (__m128 c) noexcept {
+	auto gamma = madd_ps(pow_ps(c,1.f / 2.4f),_mm_set1_ps(1.055f),-0.055f);
+	auto linear = _mm_mul_ps(c,_mm_set1_ps(12.92f));
+	auto retr = select_ps(_mm_cmpgt_ps(c,_mm_set1_ps(0.0031308f)),gamma,linear);
+	retr = _mm_mul_ps(retr,_mm_set1_ps(255.f));
+	return _mm_min_ps(_mm_max_ps(retr,_mm_setzero_ps()),_mm_set1_ps(255.f));
+}
+
+inline __m128 lab_f (__m128 t) noexcept {
+	auto linear = madd_ps(t,_mm_set1_ps(7.787f),16.f / 116.f);
+	return select_ps(_mm_cmpgt_ps(t,_mm_set1_ps(0.008856f)),pow_ps(t,1.f / 3.f),linear);
+}
+
+inline __m128 lab_f_inv (__m128 t) noexcept {
+	auto cube = _mm_mul_ps(_mm_mul_ps(t,t),t);
+	auto linear = _mm_div_ps(_mm_sub_ps(t,_mm_set1_ps(16.f / 116.f)),_mm_set1_ps(7.787f));
+	return select_ps(_mm_cmpgt_ps(cube,_mm_set1_ps(0.008856f)),cube,linear);
+}
+
+void bgr2lab_sse2_block (const cv::Vec3b * in, cv::Vec3f * out) noexcept {
+	auto && linear = detail::tables().linear;
+	alignas(16) float c[3][4];
+	for (int i = 0; i < 4; ++i) for (int j = 0; j < 3; ++j) c[j][i] = linear[in[i][j]];
+	auto b = _mm_load_ps(c[0]);
+	auto g = _mm_load_ps(c[1]);
+	auto r = _mm_load_ps(c[2]);
+	auto x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r,_mm_set1_ps(0.4124f)),_mm_mul_ps(g,_mm_set1_ps(0.3576f))),_mm_mul_ps(b,_mm_set1_ps(0.1805f)));
+	auto y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r,_mm_set1_ps(0.2126f)),_mm_mul_ps(g,_mm_set1_ps(0.7152f))),_mm_mul_ps(b,_mm_set1_ps(0.0722f)));
+	auto z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r,_mm_set1_ps(0.0193f)),_mm_mul_ps(g,_mm_set1_ps(0.1192f))),_mm_mul_ps(b,_mm_set1_ps(0.9505f)));
+	x = lab_f(_mm_div_ps(x,_mm_set1_ps(95.047f)));
+	y = lab_f(_mm_div_ps(y,_mm_set1_ps(100.f)));
+	z = lab_f(_mm_div_ps(z,_mm_set1_ps(108.883f)));
+	_mm_store_ps(c[0],madd_ps(y,_mm_set1_ps(116.f),-16.f));
+	_mm_store_ps(c[1],_mm_mul_ps(_mm_sub_ps(x,y),_mm_set1_ps(500.f)));
+	_mm_store_ps(c[2],_mm_mul_ps(_mm_sub_ps(y,z),_mm_set1_ps(200.f)));
+	for (int i = 0; i < 4; ++i) out[i] = cv::Vec3f(c[0][i],c[1][i],c[2][i]);
+}
+
+void bgr2lab_sse2 (const cv::Vec3b * in, cv::Vec3f * out, std::size_t n) noexcept {
+	std::size_t i = 0;
+	for (; (i + 8) <= n; i += 8) {
+		bgr2lab_sse2_block(in + i,out + i);
+		bgr2lab_sse2_block(in + i + 4,out + i + 4);
+	}
+	bgr2lab_scalar(in + i,out + i,n - i);
+}
+
+void lab2bgr_sse2_block (const cv::Vec3f * in, cv::Vec3b * out) noexcept {
+	alignas(16) float c[3][4];
+	for (int i = 0; i < 4; ++i) for (int j = 0; j < 3; ++j) c[j][i] = in[i][j];
+	auto y = _mm_div_ps(_mm_add_ps(_mm_load_ps(c[0]),_mm_set1_ps(16.f)),_mm_set1_ps(116.f));
+	auto x = _mm_add_ps(_mm_div_ps(_mm_load_ps(c[1]),_mm_set1_ps(500.f)),y);
+	auto z = _mm_sub_ps(y,_mm_div_ps(_mm_load_ps(c[2]),_mm_set1_ps(200.f)));
+	x = _mm_mul_ps(lab_f_inv(x),_mm_set1_ps(95.047f / 100.f));
+	y = lab_f_inv(y);
+	z = _mm_mul_ps(lab_f_inv(z),_mm_set1_ps(108.883f / 100.f));
+	auto r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x,_mm_set1_ps(3.2406f)),_mm_mul_ps(y,_mm_set1_ps(-1.5372f))),_mm_mul_ps(z,_mm_set1_ps(-0.4986f)));
+	auto g = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x,_mm_set1_ps(-0.9689f)),_mm_mul_ps(y,_mm_set1_ps(1.8758f))),_mm_mul_ps(z,_mm_set1_ps(0.0415f)));
+	auto b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x,_mm_set1_ps(0.0557f)),_mm_mul_ps(y,_mm_set1_ps(-0.2040f))),_mm_mul_ps(z,_mm_set1_ps(1.0570f)));
+	alignas(16) std::int32_t bgr[3][4];
+	_mm_store_si128(reinterpret_cast<__m128i *>(bgr[0]),_mm_cvttps_epi32(linear2srgb(b)));
+	_mm_store_si128(reinterpret_cast<__m128i *>(bgr[1]),_mm_cvttps_epi32(linear2srgb(g)));
+	_mm_store_si128(reinterpret_cast<__m128i *>(bgr[2]),_mm_cvttps_epi32(linear2srgb(r)));
+	for (int i = 0; i < 4; ++i) for (int j = 0; j < 3; ++j) out[i][j] = std::uint8_t(bgr[j][i]);
+}
+
+void lab2bgr_sse2 (const cv::Vec3f * in, cv::Vec3b * out, std::size_t n) noexcept {
+	std::size_t i = 0;
+	for (; (i + 8) <= n; i += 8) {
+		lab2bgr_sse2_block(in + i,out + i);
+		lab2bgr_sse2_block(in + i + 4,out + i + 4);
+	}
+	lab2bgr_scalar(in + i,out + i,n - i);
+}
+
+//	AVX2 and FMA (selected at runtime)
+
+COLBY_TARGET_AVX2 inline __m256 select_ps (__m256 mask, __m256 a, __m256 b) noexcept {
+	return _mm256_blendv_ps(b,a,mask);
+}
+
+COLBY_TARGET_AVX2 inline __m256 madd_ps (__m256 a, __m256 b, float c) noexcept {
+	return _mm256_fmadd_ps(a,b,_mm256_set1_ps(c));
+}
+
+COLBY_TARGET_AVX2 inline __m256 log2_ps (__m256 x) noexcept {
+	auto bits = _mm256_castps_si256(_mm256_max_ps(x,_mm256_set1_ps(1e-30f)));
+	auto e = _mm256_sub_epi32(_mm256_srli_epi32(bits,23),_mm256_set1_epi32(127));
+	auto m = _mm256_castsi256_ps(_mm256_or_si256(
+		_mm256_and_si256(bits,_mm256_set1_epi32(0x007fffff)),
+		_mm256_set1_epi32(0x3f800000)
+	));
+	auto big = _mm256_cmp_ps(m,_mm256_set1_ps(1.41421356f),_CMP_GT_OQ);
+	m = select_ps(big,_mm256_mul_ps(m,_mm256_set1_ps(0.5f)),m);
+	auto ef = _mm256_add_ps(_mm256_cvtepi32_ps(e),_mm256_and_ps(big,_mm256_set1_ps(1.f)));
+	auto one = _mm256_set1_ps(1.f);
+	auto t = _mm256_div_ps(_mm256_sub_ps(m,one),_mm256_add_ps(m,one));
+	auto t2 = _mm256_mul_ps(t,t);
+	auto p = madd_ps(t2,_mm256_set1_ps(log2_c9),log2_c7);
+	p = madd_ps(t2,p,log2_c5);
+	p = madd_ps(t2,p,log2_c3);
+	p = madd_ps(t2,p,log2_c1);
+	return _mm256_fmadd_ps(t,p,ef);
+}
+
+COLBY_TARGET_AVX2 inline __m256 exp2_ps (__m256 x) noexcept {
+	x = _mm256_min_ps(_mm256_max_ps(x,_mm256_set1_ps(-126.f)),_mm256_set1_ps(126.f));
+	auto n = _mm256_cvtps_epi32(x);
+	auto f = _mm256_sub_ps(x,_mm256_cvtepi32_ps(n));
+	auto p = madd_ps(f,_mm256_set1_ps(exp2_c7),exp2_c6);
+	p = madd_ps(f,p,exp2_c5);
+	p = madd_ps(f,p,exp2_c4);
+	p = madd_ps(f,p,exp2_c3);
+	p = madd_ps(f,p,exp2_c2);
+	p = madd_ps(f,p,exp2_c1);
+	p = madd_ps(f,p,1.f);
+	auto scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n,_mm256_set1_epi32(127)),23));
+	return _mm256_mul_ps(p,scale);
+}
+
+COLBY_TARGET_AVX2 inline __m256 pow_ps (__m256 x, float y) noexcept {
+	return exp2_ps(_mm256_mul_ps(log2_ps(x),_mm256_set1_ps(y)));
+}
+
+COLBY_TARGET_AVX2 inline __m256 linear2srgb (__m256 c) noexcept {
+	auto gamma = madd_ps(pow_ps(c,1.f / 2.4f),_mm256_set1_ps(1.055f),-0.055f);
+	auto linear = _mm256_mul_ps(c,_mm256_set1_ps(12.92f));
+	auto retr = select_ps(_mm256_cmp_ps(c,_mm256_set1_ps(0.0031308f),_CMP_GT_OQ),gamma,linear);
+	retr = _mm256_mul_ps(retr,_mm256_set1_ps(255.f));
+	return _mm256_min_ps(_mm256_max_ps(retr,_mm256_setzero_ps()),_mm256_set1_ps(255.f));
+}
+
+COLBY_TARGET_AVX2 inline __m256 lab_f (__m256 t) noexcept {
+	auto linear = madd_ps(t,_mm256_set1_ps(7.787f),16.f / 116.f);
+	return select_ps(_mm256_cmp_ps(t,_mm256_set1_ps(0.008856f),_CMP_GT_OQ),pow_ps(t,1.f / 3.f),linear);
+}
+
+COLBY_TARGET_AVX2 inline __m256 lab_f_inv (__m256 t) noexcept {
+	auto cube = _mm256_mul_ps(_mm256_mul_ps(t,t),t);
+	auto linear = _mm256_div_ps(_mm256_sub_ps(t,_mm256_set1_ps(16.f / 116.f)),_mm256_set1_ps(7.787f));
+	return select_ps(_mm256_cmp_ps(cube,_mm256_set1_ps(0.008856f),_CMP_GT_OQ),cube,linear);
+}
+
+COLBY_TARGET_AVX2 void bgr2lab_avx2 (const cv::Vec3b * in, cv::Vec3f * out, std::size_t n) noexcept {
+	auto && linear = detail::tables().linear;
+	alignas(32) float c[3][8];
+	std::size_t i = 0;
+	for (; (i + 8) <= n; i += 8) {
+		for (int j = 0; j < 8; ++j) for (int k = 0; k < 3; ++k) c[k][j] = linear[in[i + j][k]];
+		auto b = _mm256_load_ps(c[0]);
+		auto g = _mm256_load_ps(c[1]);
+		auto r = _mm256_load_ps(c[2]);
+		auto x = _mm256_fmadd_ps(r,_mm256_set1_ps(0.4124f),_mm256_fmadd_ps(g,_mm256_set1_ps(0.3576f),_mm256_mul_ps(b,_mm256_set1_ps(0.1805f))));
+		auto y = _mm256_fmadd_ps(r,_mm256_set1_ps(0.2126f),_mm256_fmadd_ps(g,_mm256_set1_ps(0.7152f),_mm256_mul_ps(b,_mm256_set1_ps(0.0722f))));
+		auto z = _mm256_fmadd_ps(r,_mm256_set1_ps(0.0193f),_mm256_fmadd_ps(g,_mm256_set1_ps(0.1192f),_mm256_mul_ps(b,_mm256_set1_ps(0.9505f))));
+		x = lab_f(_mm256_div_ps(x,_mm256_set1_ps(95.047f)));
+		y = lab_f(_mm256_div_ps(y,_mm256_set1_ps(100.f)));
+		z = lab_f(_mm256_div_ps(z,_mm256_set1_ps(108.883f)));
+		_mm256_store_ps(c[0],madd_ps(y,_mm256_set1_ps(116.f),-16.f));
+		_mm256_store_ps(c[1],_mm256_mul_ps(_mm256_sub_ps(x,y),_mm256_set1_ps(500.f)));
+		_mm256_store_ps(c[2],_mm256_mul_ps(_mm256_sub_ps(y,z),_mm256_set1_ps(200.f)));
+		for (int j = 0; j < 8; ++j) out[i + j] = cv::Vec3f(c[0][j],c[1][j],c[2][j]);
+	}
+	bgr2lab_scalar(in + i,out + i,n - i);
+}
+
+COLBY_TARGET_AVX2 void lab2bgr_avx2 (const cv::Vec3f * in, cv::Vec3b * out, std::size_t n) noexcept {
+	alignas(32) float c[3][8];
+	alignas(32) std::int32_t bgr[3][8];
+	std::size_t i = 0;
+	for (; (i + 8) <= n; i += 8) {
+		for (int j = 0; j < 8; ++j) for (int k = 0; k < 3; ++k) c[k][j] = in[i + j][k];
+		auto y = _mm256_div_ps(_mm256_add_ps(_mm256_load_ps(c[0]),_mm256_set1_ps(16.f)),_mm256_set1_ps(116.f));
+		auto x = _mm256_add_ps(_mm256_div_ps(_mm256_load_ps(c[1]),_mm256_set1_ps(500.f)),y);
+		auto z = _mm256_sub_ps(y,_mm256_div_ps(_mm256_load_ps(c[2]),_mm256_set1_ps(200.f)));
+		x = _mm256_mul_ps(lab_f_inv(x),_mm256_set1_ps(95.047f / 100.f));
+		y = lab_f_inv(y);
+		z = _mm256_mul_ps(lab_f_inv(z),_mm256_set1_ps(108.883f / 100.f));
+		auto r = _mm256_fmadd_ps(x,_mm256_set1_ps(3.2406f),_mm256_fmadd_ps(y,_mm256_set1_ps(-1.5372f),_mm256_mul_ps(z,_mm256_set1_ps(-0.4986f))));
+		auto g = _mm256_fmadd_ps(x,_mm256_set1_ps(-0.9689f),_mm256_fmadd_ps(y,_mm256_set1_ps(1.8758f),_mm256_mul_ps(z,_mm256_set1_ps(0.0415f))));
+		auto b = _mm256_fmadd_ps(x,_mm256_set1_ps(0.0557f),_mm256_fmadd_ps(y,_mm256_set1_ps(-0.2040f),_mm256_mul_ps(z,_mm256_set1_ps(1.0570f))));
+		_mm256_store_si256(reinterpret_cast<__m256i *>(bgr[0]),_mm256_cvttps_epi32(linear2srgb(b)));
+		_mm256_store_si256(reinterpret_cast<__m256i *>(bgr[1]),_mm256_cvttps_epi32(linear2srgb(g)));
+		_mm256_store_si256(reinterpret_cast<__m256i *>(bgr[2]),_mm256_cvttps_epi32(linear2srgb(r)));
+		for (int j = 0; j < 8; ++j) for (int k = 0; k < 3; ++k) out[i + j][k] = std::uint8_t(bgr[k][j]);
+	}
+	lab2bgr_scalar(in + i,out + i,n - i);
+}
+
+bool has_avx2 () noexcept {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#endif
+
+bgr2lab_kernel select_bgr2lab_kernel () noexcept {
+#ifdef COLBY_X86_SIMD
+	if (has_avx2()) return bgr2lab_avx2;
+	return bgr2lab_sse2;
+#else
+	return bgr2lab_scalar;
+#endif
+}
+
+lab2bgr_kernel select_lab2bgr_kernel () noexcept {
+#ifdef COLBY_X86_SIMD
+	if (has_avx2()) return lab2bgr_avx2;
+	return lab2bgr_sse2;
+#else
+	return lab2bgr_scalar;
+#endif
+}
+
+}
+
+cv::Mat bgr2lab(const cv::Mat & bgr, int depth) {
+	if (bgr.type() != CV_8UC3) throw std::logic_error("Expected 3 channel 8 bit image");
+	static const auto kernel = select_bgr2lab_kernel();
+	if (depth == CV_32F) {
+		cv::Mat retr(bgr.rows, bgr.cols, CV_32FC3);
+		parallel_rows(bgr,[&] (int i) noexcept {
+			kernel(bgr.ptr<cv::Vec3b>(i),retr.ptr<cv::Vec3f>(i),std::size_t(bgr.cols));
+		});
+		return retr;
+	}
+	if (depth != CV_16S) throw std::logic_error("Expected CV_32F or CV_16S");
+	cv::Mat retr(bgr.rows, bgr.cols, CV_16SC3);
+	parallel_rows(bgr,[&] (int i) noexcept {
+		cv::Vec3f buffer[chunk_size];
+		auto in = bgr.ptr<cv::Vec3b>(i);
+		auto out = retr.ptr<cv::Vec3s>(i);
+		for (int j = 0; j < bgr.cols; j += int(chunk_size)) {
+			auto n = std::min(chunk_size,std::size_t(bgr.cols - j));
+			kernel(in + j,buffer,n);
+			std::transform(buffer,buffer + n,out + j,[] (auto && v) noexcept {	return lab2fixed(v);	});
+		}
+	});
+	return retr;
+}
+
+cv::Mat bgr2lab_fast(const cv::Mat & bgr) {
+	if (bgr.type() != CV_8UC3) throw std::logic_error("Expected 3 channel 8 bit image");
+	cv::Mat retr(bgr.rows, bgr.cols, CV_32FC3);
+	parallel_rows(bgr,[&] (int i) noexcept {
+		auto begin = bgr.ptr<cv::Vec3b>(i);
+		std::transform(begin,begin + bgr.cols,retr.ptr<cv::Vec3f>(i),[] (auto && v) noexcept {	return bgr2lab_fast(v);	});
+	});
+	return retr;
+}
+
+cv::Mat bgr2lab_fast(const cv::Mat & bgr, bgr2lab_cache & cache) {
+	if (bgr.type() != CV_8UC3) throw std::logic_error("Expected 3 channel 8 bit image");
+	cv::Mat retr(bgr.rows, bgr.cols, CV_32FC3);
+	//	The cache is not thread safe so the rows
+	//	are converted serially
+	for (int i = 0; i < bgr.rows; ++i) {
+		auto begin = bgr.ptr<cv::Vec3b>(i);
+		std::transform(begin,begin + bgr.cols,retr.ptr<cv::Vec3f>(i),std::ref(cache));
+	}
+	return retr;
+}
+
+cv::Mat lab2bgr(const cv::Mat & lab) {
+	static const auto kernel = select_lab2bgr_kernel();
+	cv::Mat retr(lab.rows, lab.cols, CV_8UC3);
+	if (lab.type() == CV_32FC3) {
+		parallel_rows(lab,[&] (int i) noexcept {
+			kernel(lab.ptr<cv::Vec3f>(i),retr.ptr<cv::Vec3b>(i),std::size_t(lab.cols));
+		});
+		return retr;
+	}
+	if (lab.type() != CV_16SC3) throw std::logic_error("Expected 3 channel 32 bit floating point or 16 bit signed integer image");
+	parallel_rows(lab,[&] (int i) noexcept {
+		cv::Vec3f buffer[chunk_size];
+		auto in = lab.ptr<cv::Vec3s>(i);
+		auto out = retr.ptr<cv::Vec3b>(i);
+		for (int j = 0; j < lab.cols; j += int(chunk_size)) {
+			auto n = std::min(chunk_size,std::size_t(lab.cols - j));
+			std::transform(in + j,in + j + n,buffer,[] (auto && v) noexcept {	return fixed2lab(v);	});
+			kernel(buffer,out + j,n);
+		}
+	});
+	return retr;
+}
+
+}
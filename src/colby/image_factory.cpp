@@ -1,7 +1,32 @@
 #include <colby/image_factory.hpp>
+#include <opencv2/core/mat.hpp>
+#include <memory>
+#include <utility>
 
 namespace colby {
 
+namespace {
+
+class immediate_image_factory : public image_factory {
+private:
+	cv::Mat image_;
+public:
+	immediate_image_factory () = delete;
+	explicit immediate_image_factory (cv::Mat image) noexcept : image_(std::move(image)) {	}
+	virtual cv::Mat image () override {
+		return image_;
+	}
+	virtual std::shared_ptr<image_factory> snapshot () override {
+		return std::make_shared<immediate_image_factory>(image_);
+	}
+};
+
+}
+
 image_factory::~image_factory () noexcept {	}
 
+std::shared_ptr<image_factory> image_factory::snapshot () {
+	return std::make_shared<immediate_image_factory>(image());
+}
+
 }
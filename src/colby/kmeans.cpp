@@ -0,0 +1,273 @@
+#include <colby/kmeans.hpp>
+#include <colby/parallel.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/core/matx.hpp>
+#include <opencv2/core/types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace colby {
+
+namespace {
+
+double squared_distance (const cv::Vec3d & a, const cv::Vec3d & b) noexcept {
+	auto d = a - b;
+	return d.dot(d);
+}
+
+double distance (const cv::Vec3d & a, const cv::Vec3d & b) noexcept {
+	return std::sqrt(squared_distance(a,b));
+}
+
+//	Derives the seed of each attempt from the seed of the
+//	whole so that attempts are independent of one another
+//	(SplitMix64)
+std::uint64_t attempt_seed (std::uint64_t seed, int attempt) noexcept {
+	std::uint64_t z = seed + (std::uint64_t(attempt) + 1) * 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+//	A single attempt using Hamerly's algorithm: each point
+//	keeps an upper bound on the distance to its own center
+//	and a lower bound on the distance to every other center
+//	so that most points need not be compared against every
+//	center on every iteration
+class attempt {
+private:
+	const std::vector<cv::Vec3d> & points_;
+	const std::vector<double> & weights_;
+	std::vector<cv::Vec3d> centers_;
+	std::vector<int> labels_;
+	std::vector<double> upper_;
+	std::vector<double> lower_;
+	//	Half the distance from each center to the nearest
+	//	other center
+	std::vector<double> half_;
+	std::vector<double> moved_;
+	void seed (cv::RNG & rng) {
+		//	k-means++: each center is chosen with probability
+		//	proportional to weight multiplied by squared
+		//	distance from the nearest center already chosen
+		auto n = points_.size();
+		std::vector<double> nearest(n,std::numeric_limits<double>::max());
+		auto choose = [&] (const std::vector<double> & p) {
+			auto total = std::accumulate(p.begin(),p.end(),0.);
+			//	Every remaining point coincides with a center
+			if (!(total > 0)) return std::size_t(rng.uniform(0,int(n)));
+			auto r = rng.uniform(0.,total);
+			//	Guards against r exceeding the sum owing to
+			//	rounding
+			std::size_t last = 0;
+			for (std::size_t i = 0; i < n; ++i) {
+				if (!(p[i] > 0)) continue;
+				if (r < p[i]) return i;
+				r -= p[i];
+				last = i;
+			}
+			return last;
+		};
+		std::vector<double> p(weights_);
+		for (auto && c : centers_) {
+			c = points_[choose(p)];
+			for (std::size_t i = 0; i < n; ++i) {
+				nearest[i] = std::min(nearest[i],squared_distance(points_[i],c));
+				p[i] = weights_[i] * nearest[i];
+			}
+		}
+	}
+	void separate () noexcept {
+		auto k = centers_.size();
+		for (std::size_t a = 0; a < k; ++a) {
+			auto min = std::numeric_limits<double>::max();
+			for (std::size_t b = 0; b < k; ++b) if (a != b) min = std::min(min,distance(centers_[a],centers_[b]));
+			half_[a] = min / 2;
+		}
+	}
+	//	Finds the nearest and second nearest centers to a
+	//	point and resets its bounds
+	void search (std::size_t i) noexcept {
+		int best = 0;
+		auto best_dist = std::numeric_limits<double>::max();
+		auto second_dist = std::numeric_limits<double>::max();
+		for (std::size_t c = 0; c < centers_.size(); ++c) {
+			auto d = distance(points_[i],centers_[c]);
+			if (d < best_dist) {
+				second_dist = best_dist;
+				best = int(c);
+				best_dist = d;
+			} else if (d < second_dist) {
+				second_dist = d;
+			}
+		}
+		labels_[i] = best;
+		upper_[i] = best_dist;
+		lower_[i] = second_dist;
+	}
+	void assign () noexcept {
+		separate();
+		for (std::size_t i = 0; i < points_.size(); ++i) {
+			auto l = labels_[i];
+			auto bound = std::max(half_[l],lower_[i]);
+			if (upper_[i] <= bound) continue;
+			upper_[i] = distance(points_[i],centers_[l]);
+			if (upper_[i] <= bound) continue;
+			search(i);
+		}
+	}
+	//	Moves each center to the weighted mean of its points
+	//	and returns the largest squared distance moved by a
+	//	center
+	double update () {
+		auto k = centers_.size();
+		std::vector<cv::Vec3d> sums(k,cv::Vec3d(0,0,0));
+		std::vector<double> totals(k,0);
+		std::vector<std::size_t> counts(k,0);
+		for (std::size_t i = 0; i < points_.size(); ++i) {
+			auto l = labels_[i];
+			sums[l] += points_[i] * weights_[i];
+			totals[l] += weights_[i];
+			++counts[l];
+		}
+		//	A cluster which has lost all its points takes the
+		//	point furthest from the center of the cluster with
+		//	the most points, as cv::kmeans does.  Since there
+		//	are more points than clusters that cluster has
+		//	at least two points
+		std::vector<std::size_t> taken;
+		for (std::size_t c = 0; c < k; ++c) {
+			if (counts[c] != 0) continue;
+			auto largest = std::size_t(std::max_element(counts.begin(),counts.end()) - counts.begin());
+			cv::Vec3d center(sums[largest] / totals[largest]);
+			std::size_t furthest = 0;
+			double furthest_dist = -1;
+			for (std::size_t i = 0; i < points_.size(); ++i) {
+				if (std::size_t(labels_[i]) != largest) continue;
+				auto d = squared_distance(points_[i],center);
+				if (d > furthest_dist) {
+					furthest = i;
+					furthest_dist = d;
+				}
+			}
+			auto w = points_[furthest] * weights_[furthest];
+			sums[largest] -= w;
+			sums[c] += w;
+			totals[largest] -= weights_[furthest];
+			totals[c] += weights_[furthest];
+			--counts[largest];
+			++counts[c];
+			labels_[furthest] = int(c);
+			taken.push_back(furthest);
+		}
+		double retr = 0;
+		double max_moved = 0;
+		for (std::size_t c = 0; c < k; ++c) {
+			cv::Vec3d center(sums[c] / totals[c]);
+			auto d = squared_distance(center,centers_[c]);
+			retr = std::max(retr,d);
+			moved_[c] = std::sqrt(d);
+			max_moved = std::max(max_moved,moved_[c]);
+			centers_[c] = center;
+		}
+		for (std::size_t i = 0; i < points_.size(); ++i) {
+			upper_[i] += moved_[labels_[i]];
+			lower_[i] -= max_moved;
+		}
+		//	Points which were moved between clusters have no
+		//	valid bounds
+		for (auto i : taken) {
+			upper_[i] = std::numeric_limits<double>::max();
+			lower_[i] = 0;
+		}
+		return retr;
+	}
+public:
+	attempt (const std::vector<cv::Vec3d> & points, const std::vector<double> & weights, int k)
+		:	points_(points),
+			weights_(weights),
+			centers_(k),
+			labels_(points.size(),0),
+			upper_(points.size(),std::numeric_limits<double>::max()),
+			lower_(points.size(),0),
+			half_(k),
+			moved_(k)
+	{	}
+	void run (cv::RNG & rng, int max_iter, double epsilon) {
+		seed(rng);
+		assign();
+		for (int i = 1; i < max_iter; ++i) {
+			auto shift = update();
+			assign();
+			if (shift <= epsilon) break;
+		}
+	}
+	double compactness () const noexcept {
+		double retr = 0;
+		for (std::size_t i = 0; i < points_.size(); ++i) retr += weights_[i] * squared_distance(points_[i],centers_[labels_[i]]);
+		return retr;
+	}
+	const std::vector<int> & labels () const noexcept {
+		return labels_;
+	}
+	const std::vector<cv::Vec3d> & centers () const noexcept {
+		return centers_;
+	}
+};
+
+}
+
+double weighted_kmeans (
+	const std::vector<cv::Vec3f> & points,
+	const std::vector<double> & weights,
+	int k,
+	cv::TermCriteria criteria,
+	int attempts,
+	std::vector<int> & labels,
+	std::vector<cv::Vec3f> & centers,
+	std::uint64_t seed
+) {
+	if (weights.size() != points.size()) throw std::logic_error("Expected one weight per point");
+	if (k <= 0) throw std::logic_error("Expected a positive number of clusters");
+	if (std::any_of(weights.begin(),weights.end(),[] (double w) noexcept {	return !(w > 0);	})) throw std::logic_error("Expected positive weights");
+	labels.resize(points.size());
+	if (points.size() <= std::size_t(k)) {
+		std::iota(labels.begin(),labels.end(),0);
+		centers = points;
+		return 0;
+	}
+	//	Interpreted as by cv::kmeans
+	int max_iter = (criteria.type & cv::TermCriteria::COUNT) ? std::max(criteria.maxCount,2) : 100;
+	double epsilon = (criteria.type & cv::TermCriteria::EPS) ? std::max(criteria.epsilon,0.) : double(std::numeric_limits<float>::epsilon());
+	epsilon *= epsilon;
+	attempts = std::max(attempts,1);
+	std::vector<cv::Vec3d> ps(points.begin(),points.end());
+	//	Each attempt is computed serially from its own seed
+	//	and the best is chosen in order of attempt, so the
+	//	result does not depend on the number of threads
+	std::vector<double> compactness(attempts);
+	std::vector<std::vector<int>> attempt_labels(attempts);
+	std::vector<std::vector<cv::Vec3d>> attempt_centers(attempts);
+	parallel_for(cv::Range(0,attempts),[&] (const cv::Range & range) {
+		for (int a = range.start; a < range.end; ++a) {
+			cv::RNG rng(attempt_seed(seed,a));
+			attempt curr(ps,weights,k);
+			curr.run(rng,max_iter,epsilon);
+			compactness[a] = curr.compactness();
+			attempt_labels[a] = curr.labels();
+			attempt_centers[a] = curr.centers();
+		}
+	},attempts);
+	auto best = std::size_t(std::min_element(compactness.begin(),compactness.end()) - compactness.begin());
+	labels = std::move(attempt_labels[best]);
+	centers.assign(attempt_centers[best].begin(),attempt_centers[best].end());
+	return compactness[best];
+}
+
+}
@@ -0,0 +1,30 @@
+#include <colby/lab.hpp>
+#include <colby/parallel.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace colby {
+
+cv::Mat lab2fixed (const cv::Mat & lab) {
+	if (lab.type() != CV_32FC3) throw std::logic_error("Expected 3 channel 32 bit floating point image");
+	cv::Mat retr(lab.rows,lab.cols,CV_16SC3);
+	parallel_rows(lab,[&] (int i) noexcept {
+		auto begin = lab.ptr<cv::Vec3f>(i);
+		std::transform(begin,begin + lab.cols,retr.ptr<cv::Vec3s>(i),[] (auto && v) noexcept {	return lab2fixed(v);	});
+	});
+	return retr;
+}
+
+cv::Mat fixed2lab (const cv::Mat & lab) {
+	if (lab.type() != CV_16SC3) throw std::logic_error("Expected 3 channel 16 bit signed integer image");
+	cv::Mat retr(lab.rows,lab.cols,CV_32FC3);
+	parallel_rows(lab,[&] (int i) noexcept {
+		auto begin = lab.ptr<cv::Vec3s>(i);
+		std::transform(begin,begin + lab.cols,retr.ptr<cv::Vec3f>(i),[] (auto && v) noexcept {	return fixed2lab(v);	});
+	});
+	return retr;
+}
+
+}
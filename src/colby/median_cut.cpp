@@ -0,0 +1,126 @@
+#include <colby/median_cut.hpp>
+#include <opencv2/core/matx.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace colby {
+
+namespace {
+
+double squared_distance (const cv::Vec3d & a, const cv::Vec3d & b) noexcept {
+	auto d = a - b;
+	return d.dot(d);
+}
+
+//	A contiguous range of a permutation of the points
+class box {
+public:
+	std::size_t begin;
+	std::size_t end;
+	cv::Vec3d mean;
+	//	The weighted sum of squared deviations from the
+	//	mean along each axis
+	cv::Vec3d deviation;
+	double error () const noexcept {
+		return deviation[0] + deviation[1] + deviation[2];
+	}
+};
+
+box make_box (const std::vector<cv::Vec3d> & points, const std::vector<double> & weights, const std::vector<std::size_t> & order, std::size_t begin, std::size_t end) noexcept {
+	box retr;
+	retr.begin = begin;
+	retr.end = end;
+	cv::Vec3d sum(0,0,0);
+	double total = 0;
+	for (auto i = begin; i < end; ++i) {
+		auto p = order[i];
+		sum += points[p] * weights[p];
+		total += weights[p];
+	}
+	retr.mean = sum / total;
+	retr.deviation = cv::Vec3d(0,0,0);
+	for (auto i = begin; i < end; ++i) {
+		auto p = order[i];
+		auto d = points[p] - retr.mean;
+		for (int j = 0; j < 3; ++j) retr.deviation[j] += weights[p] * d[j] * d[j];
+	}
+	return retr;
+}
+
+}
+
+double median_cut (
+	const std::vector<cv::Vec3f> & points,
+	const std::vector<double> & weights,
+	int k,
+	std::vector<int> & labels,
+	std::vector<cv::Vec3f> & palette
+) {
+	if (weights.size() != points.size()) throw std::logic_error("Expected one weight per point");
+	if (k <= 0) throw std::logic_error("Expected a positive number of colors");
+	if (std::any_of(weights.begin(),weights.end(),[] (double w) noexcept {	return !(w > 0);	})) throw std::logic_error("Expected positive weights");
+	labels.clear();
+	palette.clear();
+	if (points.empty()) return 0;
+	std::vector<cv::Vec3d> ps(points.begin(),points.end());
+	std::vector<std::size_t> order(points.size());
+	std::iota(order.begin(),order.end(),std::size_t(0));
+	std::vector<box> boxes{make_box(ps,weights,order,0,order.size())};
+	while (boxes.size() < std::size_t(k)) {
+		auto split = std::max_element(boxes.begin(),boxes.end(),[] (const box & a, const box & b) noexcept {
+			return a.error() < b.error();
+		});
+		//	Every box contains only identical points
+		if (!(split->error() > 0)) break;
+		auto b = *split;
+		auto axis = int(std::max_element(b.deviation.val,b.deviation.val + 3) - b.deviation.val);
+		auto begin = order.begin() + b.begin;
+		auto end = order.begin() + b.end;
+		//	Ties are broken by index so the result does not
+		//	depend on the sorting algorithm
+		std::sort(begin,end,[&] (std::size_t x, std::size_t y) noexcept {
+			if (ps[x][axis] != ps[y][axis]) return ps[x][axis] < ps[y][axis];
+			return x < y;
+		});
+		double total = 0;
+		for (auto i = begin; i != end; ++i) total += weights[*i];
+		//	The weighted median, moved if necessary so that
+		//	points with equal coordinates stay together
+		//	and neither half is empty.  Since the points
+		//	vary along this axis such a position exists
+		auto mid = begin;
+		for (double sum = 0; (sum + weights[*mid]) <= (total / 2); ++mid) sum += weights[*mid];
+		auto same = [&] (std::size_t x, std::size_t y) noexcept {	return ps[x][axis] == ps[y][axis];	};
+		while ((mid != begin) && (mid != end) && same(*(mid - 1),*mid)) --mid;
+		if (mid == begin) {
+			++mid;
+			while (same(*(mid - 1),*mid)) ++mid;
+		}
+		auto m = b.begin + std::size_t(mid - begin);
+		*split = make_box(ps,weights,order,b.begin,m);
+		boxes.push_back(make_box(ps,weights,order,m,b.end));
+	}
+	for (auto && b : boxes) palette.push_back(cv::Vec3f(b.mean));
+	//	Each point is recolored with the nearest color in
+	//	the palette, which need not be that of its box
+	labels.resize(points.size());
+	double retr = 0;
+	for (std::size_t i = 0; i < points.size(); ++i) {
+		auto best = std::numeric_limits<double>::max();
+		for (std::size_t c = 0; c < boxes.size(); ++c) {
+			auto d = squared_distance(ps[i],boxes[c].mean);
+			if (d < best) {
+				best = d;
+				labels[i] = int(c);
+			}
+		}
+		retr += weights[i] * best;
+	}
+	return retr;
+}
+
+}
@@ -1,15 +1,34 @@
+#include <colby/image_factory.hpp>
 #include <colby/sp3000_color_by_numbers_observer.hpp>
+#include <opencv2/core/mat.hpp>
+#include <memory>
+#include <utility>
 
 namespace colby {
 
 sp3000_color_by_numbers_observer::~sp3000_color_by_numbers_observer () noexcept {	}
 
-sp3000_color_by_numbers_observer::base_event::base_event (image_factory & factory) noexcept
-	:	factory_(factory)
+sp3000_color_by_numbers_observer::base_event::base_event (image_factory & factory, const stage_statistics & statistics) noexcept
+	:	factory_(&factory),
+		statistics_(statistics)
 {	}
 
+sp3000_color_by_numbers_observer::base_event::base_event (std::shared_ptr<image_factory> factory, const stage_statistics & statistics) noexcept
+	:	owned_(std::move(factory)),
+		factory_(owned_.get()),
+		statistics_(statistics)
+{	}
+
+const sp3000_color_by_numbers_observer::stage_statistics & sp3000_color_by_numbers_observer::base_event::statistics () const noexcept {
+	return statistics_;
+}
+
 cv::Mat sp3000_color_by_numbers_observer::base_event::image () const {
-	return factory_.image();
+	return factory_->image();
+}
+
+sp3000_color_by_numbers_observer::base_event sp3000_color_by_numbers_observer::base_event::snapshot () const {
+	return base_event(factory_->snapshot(),statistics_);
 }
 
 }
@@ -1,9 +1,14 @@
 #include <colby/algorithm.hpp>
 #include <colby/hash.hpp>
+#include <colby/timer.hpp>
+#include <opencv2/core.hpp>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/types.hpp>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <unordered_set>
+#include <vector>
 #include <catch.hpp>
 
 namespace colby {
@@ -43,6 +48,38 @@ SCENARIO("colby::neighbors generates callbacks for all neighbors in the four-nei
 	}
 }
 
+SCENARIO("colby::neighbors may generate callbacks for all neighbors in the eight-neighborhood of a given point","[colby][algorithm][neighbors]") {
+	GIVEN("An image") {
+		cv::Mat mat(cv::Mat::zeros(3,3,CV_32FC3));
+		WHEN("A position on the edge is checked") {
+			std::unordered_set<cv::Point> points;
+			neighbors<eight_neighborhood>(mat,cv::Point(0,0),[&] (auto p) {	points.insert(p);	});
+			THEN("Callbacks are generated for the correct neighbors") {
+				CHECK(points.size() == 3U);
+				CHECK(points.count(cv::Point(1,0)) == 1U);
+				CHECK(points.count(cv::Point(0,1)) == 1U);
+				CHECK(points.count(cv::Point(1,1)) == 1U);
+			}
+		}
+		WHEN("A position in the interior is checked") {
+			std::unordered_set<cv::Point> points;
+			neighbors<eight_neighborhood>(mat,cv::Point(1,1),[&] (auto p) {	points.insert(p);	});
+			THEN("Callbacks are generated for all eight neighbors") {
+				CHECK(points.size() == 8U);
+				CHECK(points.count(cv::Point(1,1)) == 0U);
+			}
+		}
+		WHEN("A position in the interior is checked using the four-neighborhood") {
+			std::unordered_set<cv::Point> points;
+			neighbors(mat,cv::Point(1,1),[&] (auto p) {	points.insert(p);	});
+			THEN("Callbacks are generated for the four neighbors which share an edge") {
+				CHECK(points.size() == 4U);
+				CHECK(points.count(cv::Point(0,0)) == 0U);
+			}
+		}
+	}
+}
+
 SCENARIO("colby::flood_fill may be used to select an area of pixels","[colby][algorithm][flood_fill]") {
 	GIVEN("An image") {
 		cv::Mat mat(cv::Mat::zeros(2,2,CV_32FC3));
@@ -66,6 +103,171 @@ SCENARIO("colby::flood_fill may be used to select an area of pixels","[colby][al
 	}
 }
 
+SCENARIO("colby::scanline_flood_fill may be used to label an area of pixels","[colby][algorithm][scanline_flood_fill]") {
+	GIVEN("An image") {
+		cv::Mat mat(cv::Mat::zeros(2,2,CV_32FC3));
+		cv::Mat labels(2,2,CV_32SC1,cv::Scalar::all(-1));
+		WHEN("colby::scanline_flood_fill is called thereupon with a functor which returns true unconditionally") {
+			std::size_t n = 0;
+			auto count = scanline_flood_fill(mat,cv::Point(1,1),[&] (const auto &) noexcept {
+				++n;
+				return true;
+			},labels,3);
+			THEN("The provided callback is invoked the appropriate number of times") {
+				CHECK(n == 4U);
+			}
+			THEN("All pixels are labeled") {
+				CHECK(count == 4U);
+				CHECK(labels.at<int>(0,0) == 3);
+				CHECK(labels.at<int>(0,1) == 3);
+				CHECK(labels.at<int>(1,0) == 3);
+				CHECK(labels.at<int>(1,1) == 3);
+			}
+		}
+	}
+	GIVEN("An image containing a spiral") {
+		//	The spiral requires the fill to travel both up
+		//	and down as well as to the left and right
+		const char * rows [] = {
+			"#########",
+			"........#",
+			"#######.#",
+			"#.....#.#",
+			"#.###.#.#",
+			"#.#...#.#",
+			"#.#####.#",
+			"#.......#",
+			"#########"
+		};
+		cv::Mat mat(9,9,CV_8UC1);
+		for (int i = 0; i < mat.rows; ++i) for (int j = 0; j < mat.cols; ++j) {
+			mat.at<std::uint8_t>(i,j) = rows[i][j] == '#' ? 1 : 0;
+		}
+		auto callback = [&] (cv::Point p) noexcept {	return mat.at<std::uint8_t>(p) == 0;	};
+		WHEN("colby::scanline_flood_fill is called thereupon") {
+			cv::Mat labels(mat.rows,mat.cols,CV_32SC1,cv::Scalar::all(-1));
+			auto count = scanline_flood_fill(mat,cv::Point(0,1),callback,labels,0);
+			THEN("The same points are selected as by colby::flood_fill") {
+				auto set = flood_fill(mat,cv::Point(0,1),callback);
+				CHECK(count == set.size());
+				for (int i = 0; i < mat.rows; ++i) for (int j = 0; j < mat.cols; ++j) {
+					cv::Point p(j,i);
+					CHECK((labels.at<int>(p) == 0) == (set.count(p) != 0));
+				}
+			}
+		}
+	}
+	GIVEN("An image containing a diagonal line") {
+		cv::Mat mat(cv::Mat::zeros(5,5,CV_8UC1));
+		for (int i = 0; i < mat.rows; ++i) mat.at<std::uint8_t>(i,4 - i) = 1;
+		auto callback = [&] (cv::Point p) noexcept {	return mat.at<std::uint8_t>(p) == 1;	};
+		WHEN("colby::scanline_flood_fill is called thereupon using the eight-neighborhood") {
+			cv::Mat labels(mat.rows,mat.cols,CV_32SC1,cv::Scalar::all(-1));
+			auto count = scanline_flood_fill<eight_neighborhood>(mat,cv::Point(4,0),callback,labels,0);
+			THEN("The entire line is selected") {
+				CHECK(count == 5U);
+				CHECK(labels.at<int>(4,0) == 0);
+			}
+		}
+		WHEN("colby::scanline_flood_fill is called thereupon using the four-neighborhood") {
+			cv::Mat labels(mat.rows,mat.cols,CV_32SC1,cv::Scalar::all(-1));
+			auto count = scanline_flood_fill(mat,cv::Point(4,0),callback,labels,0);
+			THEN("Only the starting point is selected") {
+				CHECK(count == 1U);
+			}
+		}
+	}
+	GIVEN("A random binary image") {
+		cv::Mat mat(64,64,CV_8UC1);
+		cv::RNG rng(1);
+		for (int i = 0; i < mat.rows; ++i) for (int j = 0; j < mat.cols; ++j) {
+			mat.at<std::uint8_t>(i,j) = rng.uniform(0,3) == 0 ? 1 : 0;
+		}
+		WHEN("It is partitioned by repeated calls to colby::scanline_flood_fill") {
+			cv::Mat labels(mat.rows,mat.cols,CV_32SC1,cv::Scalar::all(-1));
+			std::vector<span> stack;
+			int label = 0;
+			bool same = true;
+			for (int i = 0; i < mat.rows; ++i) for (int j = 0; j < mat.cols; ++j) {
+				if (labels.at<int>(i,j) >= 0) continue;
+				cv::Point start(j,i);
+				auto value = mat.at<std::uint8_t>(start);
+				auto callback = [&] (cv::Point p) noexcept {	return mat.at<std::uint8_t>(p) == value;	};
+				auto count = scanline_flood_fill(mat,start,callback,labels,label,stack);
+				auto set = flood_fill(mat,start,callback);
+				if (count != set.size()) same = false;
+				for (auto && p : set) if (labels.at<int>(p) != label) same = false;
+				++label;
+			}
+			THEN("Each region is the same as that selected by colby::flood_fill") {
+				CHECK(same);
+			}
+		}
+		WHEN("It is partitioned by repeated calls to colby::scanline_flood_fill using the eight-neighborhood") {
+			cv::Mat labels(mat.rows,mat.cols,CV_32SC1,cv::Scalar::all(-1));
+			std::vector<span> stack;
+			int label = 0;
+			bool same = true;
+			for (int i = 0; i < mat.rows; ++i) for (int j = 0; j < mat.cols; ++j) {
+				if (labels.at<int>(i,j) >= 0) continue;
+				cv::Point start(j,i);
+				auto value = mat.at<std::uint8_t>(start);
+				auto callback = [&] (cv::Point p) noexcept {	return mat.at<std::uint8_t>(p) == value;	};
+				auto count = scanline_flood_fill<eight_neighborhood>(mat,start,callback,labels,label,stack);
+				auto set = flood_fill<eight_neighborhood>(mat,start,callback);
+				if (count != set.size()) same = false;
+				for (auto && p : set) if (labels.at<int>(p) != label) same = false;
+				++label;
+			}
+			THEN("Each region is the same as that selected by colby::flood_fill") {
+				CHECK(same);
+			}
+		}
+	}
+}
+
+SCENARIO("colby::scanline_flood_fill is faster than colby::flood_fill","[.][benchmark][colby][algorithm][scanline_flood_fill]") {
+	GIVEN("A large image consisting of stripes") {
+		cv::Mat mat(1024,1024,CV_8UC1);
+		for (int i = 0; i < mat.rows; ++i) for (int j = 0; j < mat.cols; ++j) {
+			mat.at<std::uint8_t>(i,j) = ((i + j) / 64) % 2;
+		}
+		WHEN("The image is partitioned using each flood fill") {
+			cv::Mat labels(mat.rows,mat.cols,CV_32SC1,cv::Scalar::all(-1));
+			std::vector<span> spans;
+			timer t;
+			std::size_t regions = 0;
+			for (int i = 0; i < mat.rows; ++i) for (int j = 0; j < mat.cols; ++j) {
+				if (labels.at<int>(i,j) >= 0) continue;
+				auto value = mat.at<std::uint8_t>(i,j);
+				scanline_flood_fill(mat,cv::Point(j,i),[&] (cv::Point p) noexcept {
+					return mat.at<std::uint8_t>(p) == value;
+				},labels,int(regions++),spans);
+			}
+			auto scanline = t.elapsed();
+			t.restart();
+			std::unordered_set<cv::Point> visited;
+			std::unordered_set<cv::Point> set;
+			std::vector<cv::Point> stack;
+			for (int i = 0; i < mat.rows; ++i) for (int j = 0; j < mat.cols; ++j) {
+				cv::Point start(j,i);
+				if (visited.count(start) != 0) continue;
+				auto value = mat.at<std::uint8_t>(start);
+				set = flood_fill(mat,start,[&] (cv::Point p) noexcept {
+					return mat.at<std::uint8_t>(p) == value;
+				},std::move(set),stack);
+				visited.insert(set.begin(),set.end());
+			}
+			auto hashed = t.elapsed();
+			using ms = std::chrono::duration<double,std::milli>;
+			WARN("colby::flood_fill: " << ms(hashed).count() << "ms, colby::scanline_flood_fill: " << ms(scanline).count() << "ms (" << regions << " regions)");
+			THEN("colby::scanline_flood_fill is faster") {
+				CHECK(scanline < hashed);
+			}
+		}
+	}
+}
+
 }
 }
 }
@@ -0,0 +1,163 @@
+#include <colby/async_sp3000_color_by_numbers_observer.hpp>
+#include <colby/image_factory.hpp>
+#include <colby/sp3000_color_by_numbers_observer.hpp>
+#include <opencv2/core/mat.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+//	Produces a 1x1 image holding the current value of
+//	a counter
+class counter_image_factory : public image_factory {
+private:
+	const int & value_;
+public:
+	explicit counter_image_factory (const int & value) noexcept : value_(value) {	}
+	virtual cv::Mat image () override {
+		cv::Mat retr(1,1,CV_32SC1);
+		retr.at<int>(0,0) = value_;
+		return retr;
+	}
+};
+
+class recording_observer : public sp3000_color_by_numbers_observer {
+private:
+	void record (std::string name, base_event e) {
+		std::unique_lock<std::mutex> l(m_);
+		cv_.wait(l,[&] () noexcept {	return !blocked;	});
+		if (name == fail) throw std::runtime_error("Failed");
+		names.push_back(std::move(name));
+		values.push_back(e.image().at<int>(0,0));
+		merges.push_back(e.statistics().merges);
+		threads.push_back(std::this_thread::get_id());
+	}
+	std::mutex m_;
+	std::condition_variable cv_;
+public:
+	bool blocked = false;
+	std::string fail;
+	std::vector<std::string> names;
+	std::vector<int> values;
+	std::vector<std::size_t> merges;
+	std::vector<std::thread::id> threads;
+	void block () {
+		std::lock_guard<std::mutex> l(m_);
+		blocked = true;
+	}
+	void unblock () {
+		{
+			std::lock_guard<std::mutex> l(m_);
+			blocked = false;
+		}
+		cv_.notify_all();
+	}
+	virtual void flood_fill (flood_fill_event e) override {
+		record("flood_fill",e);
+	}
+	virtual void merge_small_cells (merge_small_cells_event e) override {
+		record("merge_small_cells",e);
+	}
+	virtual void merge_similar_cells (merge_similar_cells_event e) override {
+		record("merge_similar_cells",e);
+	}
+	virtual void n_merge (n_merge_event e) override {
+		record("n_merge",e);
+	}
+	virtual void p_merge (p_merge_event e) override {
+		record("p_merge",e);
+	}
+	virtual void gaussian_smooth (gaussian_smooth_event e) override {
+		record("gaussian_smooth",e);
+	}
+};
+
+sp3000_color_by_numbers_observer::stage_statistics make_statistics (std::size_t merges) noexcept {
+	sp3000_color_by_numbers_observer::stage_statistics retr;
+	retr.regions = 0;
+	retr.merges = merges;
+	retr.pixels = 0;
+	retr.elapsed = timer::duration::zero();
+	retr.peak_memory = 0;
+	return retr;
+}
+
+SCENARIO("colby::async_sp3000_color_by_numbers_observer delivers snapshots of events on another thread","[colby][async_sp3000_color_by_numbers_observer]") {
+	recording_observer r;
+	int value = 0;
+	counter_image_factory factory(value);
+	GIVEN("An async_sp3000_color_by_numbers_observer") {
+		async_sp3000_color_by_numbers_observer async(r);
+		WHEN("Events occur while the state from which their images are produced changes") {
+			r.block();
+			value = 1;
+			async.flood_fill(sp3000_color_by_numbers_observer::base_event(factory,make_statistics(0)));
+			value = 2;
+			async.merge_small_cells(sp3000_color_by_numbers_observer::base_event(factory,make_statistics(3)));
+			value = 3;
+			async.n_merge(sp3000_color_by_numbers_observer::base_event(factory,make_statistics(5)));
+			value = 4;
+			r.unblock();
+			async.flush();
+			THEN("The events are delivered in order") {
+				std::vector<std::string> expected{"flood_fill","merge_small_cells","n_merge"};
+				CHECK(r.names == expected);
+			}
+			THEN("Each image is that which was current when the event occurred") {
+				std::vector<int> expected{1,2,3};
+				CHECK(r.values == expected);
+			}
+			THEN("The statistics are delivered with the events") {
+				std::vector<std::size_t> expected{0,3,5};
+				CHECK(r.merges == expected);
+			}
+			THEN("The events are delivered on another thread") {
+				REQUIRE(r.threads.size() == 3);
+				CHECK(r.threads[0] != std::this_thread::get_id());
+			}
+		}
+		WHEN("The observer throws while handling an event") {
+			r.fail = "p_merge";
+			async.p_merge(sp3000_color_by_numbers_observer::base_event(factory,make_statistics(0)));
+			THEN("Flushing throws") {
+				CHECK_THROWS_AS(async.flush(),std::runtime_error);
+				AND_THEN("Subsequent events are delivered") {
+					async.gaussian_smooth(sp3000_color_by_numbers_observer::base_event(factory,make_statistics(0)));
+					async.flush();
+					std::vector<std::string> expected{"gaussian_smooth"};
+					CHECK(r.names == expected);
+				}
+			}
+		}
+	}
+	GIVEN("An async_sp3000_color_by_numbers_observer which is destroyed while events are outstanding") {
+		{
+			async_sp3000_color_by_numbers_observer async(r,1);
+			value = 7;
+			async.merge_similar_cells(sp3000_color_by_numbers_observer::base_event(factory,make_statistics(0)));
+			value = 8;
+			async.p_merge(sp3000_color_by_numbers_observer::base_event(factory,make_statistics(0)));
+		}
+		THEN("The outstanding events are delivered") {
+			std::vector<int> expected{7,8};
+			CHECK(r.values == expected);
+		}
+	}
+	GIVEN("A capacity of zero") {
+		THEN("Creating an async_sp3000_color_by_numbers_observer throws") {
+			CHECK_THROWS_AS(async_sp3000_color_by_numbers_observer(r,0),std::logic_error);
+		}
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,27 @@
+#include <colby/bits.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+SCENARIO("colby::detail::lowest_set_bit finds the lowest set bit of a mask","[colby][bits]") {
+	GIVEN("Masks whose lowest set bit is each of the 32 bits") {
+		THEN("The index of that bit is found regardless of the higher bits") {
+			bool found = true;
+			for (std::size_t i = 0; i < 32; ++i) {
+				auto bit = std::uint32_t(1) << i;
+				if (detail::lowest_set_bit(bit) != i) found = false;
+				if (detail::lowest_set_bit(bit | 0x80000000U) != i) found = false;
+				if (detail::lowest_set_bit(~(bit - 1U)) != i) found = false;
+			}
+			CHECK(found);
+		}
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,216 @@
+#include <colby/components.hpp>
+#include <colby/lab.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <cstdint>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+SCENARIO("colby::label_components partitions an image into regions of similar color","[colby][components][label_components]") {
+	GIVEN("An image of a single color") {
+		cv::Mat img(7,9,CV_32FC3,cv::Scalar(50,10,-10));
+		WHEN("colby::label_components is called thereupon") {
+			cv::Mat labels;
+			auto n = label_components<cv::Vec3f>(img,1.f,labels);
+			THEN("There is a single region") {
+				CHECK(n == 1);
+				REQUIRE(labels.type() == CV_32SC1);
+				CHECK(cv::countNonZero(labels) == 0);
+			}
+		}
+	}
+	GIVEN("An image consisting of a ring around a differently colored center") {
+		cv::Mat img(5,5,CV_32FC3,cv::Scalar(0,0,0));
+		img(cv::Rect(1,1,3,3)).setTo(cv::Scalar(100,0,0));
+		img.at<cv::Vec3f>(2,2) = cv::Vec3f(0,0,0);
+		WHEN("colby::label_components is called thereupon") {
+			cv::Mat labels;
+			auto n = label_components<cv::Vec3f>(img,1.f,labels);
+			THEN("The center is not connected to the ring") {
+				CHECK(n == 3);
+				CHECK(labels.at<int>(0,0) == 0);
+				CHECK(labels.at<int>(4,4) == 0);
+				CHECK(labels.at<int>(1,1) == 1);
+				CHECK(labels.at<int>(3,3) == 1);
+				CHECK(labels.at<int>(2,2) == 2);
+			}
+		}
+	}
+	GIVEN("An image in which the lightness of each pixel in a row increases gradually") {
+		cv::Mat img(3,40,CV_32FC3);
+		for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+			img.at<cv::Vec3f>(i,j) = cv::Vec3f(float(j),0,0);
+		}
+		WHEN("colby::label_components is called thereupon") {
+			cv::Mat labels;
+			auto n = label_components<cv::Vec3f>(img,100.f,labels);
+			THEN("Regions are limited by their distance from their seed rather than from their neighbors") {
+				CHECK(n == 4);
+				for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+					CHECK(labels.at<int>(i,j) == (j / 10));
+				}
+			}
+		}
+	}
+	GIVEN("A U-shaped region") {
+		cv::Mat img(3,3,CV_16SC3,cv::Scalar(0,0,0));
+		img.at<cv::Vec3s>(0,1) = cv::Vec3s(6400,0,0);
+		img.at<cv::Vec3s>(1,1) = cv::Vec3s(6400,0,0);
+		WHEN("colby::label_components is called thereupon") {
+			cv::Mat labels;
+			auto n = label_components<cv::Vec3s>(img,lab_traits<cv::Vec3s>::from_squared_distance(1.f),labels);
+			THEN("The arms of the U are part of the same region") {
+				CHECK(n == 2);
+				CHECK(labels.at<int>(0,0) == 0);
+				CHECK(labels.at<int>(0,2) == 0);
+				CHECK(labels.at<int>(2,1) == 0);
+				CHECK(labels.at<int>(0,1) == 1);
+				CHECK(labels.at<int>(1,1) == 1);
+			}
+		}
+	}
+}
+
+SCENARIO("colby::label_components may consider diagonal neighbors","[colby][components][label_components]") {
+	GIVEN("An image containing a diagonal line") {
+		cv::Mat img(5,5,CV_32FC3,cv::Scalar(0,0,0));
+		for (int i = 0; i < img.rows; ++i) img.at<cv::Vec3f>(i,4 - i) = cv::Vec3f(100,0,0);
+		WHEN("colby::label_components is called thereupon using the eight-neighborhood") {
+			cv::Mat labels;
+			auto n = label_components<cv::Vec3f,eight_neighborhood>(img,1.f,labels);
+			THEN("The line is a single region") {
+				CHECK(n == 2);
+				for (int i = 0; i < img.rows; ++i) CHECK(labels.at<int>(i,4 - i) == 1);
+			}
+			THEN("The regions on either side of the line are united through their corners") {
+				CHECK(labels.at<int>(0,0) == 0);
+				CHECK(labels.at<int>(4,4) == 0);
+			}
+		}
+		WHEN("colby::label_components is called thereupon using the four-neighborhood") {
+			cv::Mat labels;
+			auto n = label_components<cv::Vec3f>(img,1.f,labels);
+			THEN("Each point on the line is a separate region") {
+				CHECK(n == 7);
+			}
+		}
+	}
+}
+
+SCENARIO("colby::parallel_label_components partitions an image into regions of similar color concurrently","[colby][components][parallel_label_components]") {
+	GIVEN("An image consisting of irregular uniformly colored regions") {
+		cv::Mat img(61,47,CV_32FC3);
+		cv::RNG rng(5);
+		for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+			//	Mostly extend the region above or to the left so
+			//	that regions span strips
+			cv::Vec3f c(float(rng.uniform(0,4) * 20),0,0);
+			auto r = rng.uniform(0,8);
+			if ((r < 3) && (i != 0)) c = img.at<cv::Vec3f>(i - 1,j);
+			else if ((r < 6) && (j != 0)) c = img.at<cv::Vec3f>(i,j - 1);
+			img.at<cv::Vec3f>(i,j) = c;
+		}
+		cv::Mat expected;
+		auto expected_n = label_components<cv::Vec3f>(img,1.f,expected);
+		for (std::size_t strips : {1U,2U,3U,7U,61U,100U}) {
+			WHEN("colby::parallel_label_components is called thereupon with " << strips << " strips") {
+				cv::Mat labels;
+				auto n = parallel_label_components<cv::Vec3f>(img,1.f,labels,strips);
+				THEN("The result is identical to that of colby::label_components") {
+					CHECK(n == expected_n);
+					REQUIRE(labels.type() == CV_32SC1);
+					int mismatches = 0;
+					for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+						if (labels.at<int>(i,j) != expected.at<int>(i,j)) ++mismatches;
+					}
+					CHECK(mismatches == 0);
+				}
+			}
+			WHEN("colby::parallel_label_components is called thereupon with " << strips << " strips using the eight-neighborhood") {
+				cv::Mat expected8;
+				auto expected8_n = label_components<cv::Vec3f,eight_neighborhood>(img,1.f,expected8);
+				cv::Mat labels;
+				auto n = parallel_label_components<cv::Vec3f,eight_neighborhood>(img,1.f,labels,strips);
+				THEN("The result is identical to that of colby::label_components") {
+					CHECK(n == expected8_n);
+					int mismatches = 0;
+					for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+						if (labels.at<int>(i,j) != expected8.at<int>(i,j)) ++mismatches;
+					}
+					CHECK(mismatches == 0);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("colby::label_equal_components partitions an image into regions of equal index","[colby][components][label_equal_components]") {
+	GIVEN("A U-shaped region") {
+		cv::Mat img(3,3,CV_8UC1,cv::Scalar(0));
+		img.at<std::uint8_t>(0,1) = 1;
+		img.at<std::uint8_t>(1,1) = 1;
+		WHEN("colby::label_equal_components is called thereupon") {
+			cv::Mat labels;
+			auto n = label_equal_components<std::uint8_t>(img,labels);
+			THEN("The arms of the U are united") {
+				CHECK(n == 2);
+				REQUIRE(labels.type() == CV_32SC1);
+				CHECK(labels.at<int>(0,0) == 0);
+				CHECK(labels.at<int>(0,2) == 0);
+				CHECK(labels.at<int>(0,1) == 1);
+				CHECK(labels.at<int>(1,1) == 1);
+			}
+		}
+	}
+	GIVEN("A wide image of a handful of indices and the corresponding image of colors") {
+		cv::Mat img(23,75,CV_8UC1);
+		cv::Mat ints(img.rows,img.cols,CV_32SC1);
+		cv::Mat colors(img.rows,img.cols,CV_32FC3);
+		for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+			auto index = std::uint8_t((((i / 3) * 7) + ((j * j) / 11) + ((i * j) % 5 == 0 ? 1 : 0)) % 4);
+			img.at<std::uint8_t>(i,j) = index;
+			ints.at<int>(i,j) = index;
+			colors.at<cv::Vec3f>(i,j) = cv::Vec3f(float(index) * 20.f,0,0);
+		}
+		WHEN("Four-connected regions are labeled") {
+			cv::Mat labels;
+			cv::Mat int_labels;
+			cv::Mat expected;
+			auto n = label_equal_components<std::uint8_t>(img,labels);
+			auto int_n = label_equal_components<int>(ints,int_labels);
+			auto expected_n = label_components<cv::Vec3f>(colors,1.f,expected);
+			THEN("The result is the same as that of colby::label_components") {
+				CHECK(n == expected_n);
+				CHECK(int_n == expected_n);
+				int mismatches = 0;
+				for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+					if (labels.at<int>(i,j) != expected.at<int>(i,j)) ++mismatches;
+					if (int_labels.at<int>(i,j) != expected.at<int>(i,j)) ++mismatches;
+				}
+				CHECK(mismatches == 0);
+			}
+		}
+		WHEN("Eight-connected regions are labeled") {
+			cv::Mat labels;
+			cv::Mat expected;
+			auto n = label_equal_components<std::uint8_t,eight_neighborhood>(img,labels);
+			auto expected_n = label_components<cv::Vec3f,eight_neighborhood>(colors,1.f,expected);
+			THEN("The result is the same as that of colby::label_components") {
+				CHECK(n == expected_n);
+				int mismatches = 0;
+				for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+					if (labels.at<int>(i,j) != expected.at<int>(i,j)) ++mismatches;
+				}
+				CHECK(mismatches == 0);
+			}
+		}
+	}
+}
+
+}
+}
+}
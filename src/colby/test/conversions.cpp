@@ -1,6 +1,12 @@
 #include <colby/conversions.hpp>
+#include <opencv2/core/mat.hpp>
 #include <opencv2/core/matx.hpp>
+#include <opencv2/core/types.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
 #include <catch.hpp>
 
 namespace colby {
@@ -73,6 +79,99 @@ SCENARIO("colby::bgr2lab converts RGB points into Lab points","[colby][conversio
 			}
 		}
 	}
+
+	GIVEN("A cv::Mat containing a large sample of RGB values") {
+		//	An odd number of pixels so that both the vectorized
+		//	and the scalar tail of the conversion are exercised
+		cv::Mat bgr(37,1001,CV_8UC3);
+		for (int i = 0; i < bgr.rows; ++i) for (int j = 0; j < bgr.cols; ++j) {
+			auto n = (i * bgr.cols) + j;
+			bgr.at<cv::Vec3b>(i,j) = cv::Vec3b(n % 256,(n / 7) % 256,(n / 151) % 256);
+		}
+		WHEN("It is converted to Lab") {
+			auto lab = bgr2lab(bgr);
+			THEN("Each value matches the result of converting the corresponding pixel individually") {
+				float max = 0;
+				for (int i = 0; i < bgr.rows; ++i) for (int j = 0; j < bgr.cols; ++j) {
+					auto expected = bgr2lab(bgr.at<cv::Vec3b>(i,j));
+					auto actual = lab.at<cv::Vec3f>(i,j);
+					for (int k = 0; k < 3; ++k) max = std::max(max,std::abs(expected[k] - actual[k]));
+				}
+				CHECK(max < 0.001f);
+			}
+		}
+	}
+
+	GIVEN("A region of interest within a larger cv::Mat of RGB values") {
+		cv::Mat whole(cv::Mat::zeros(10,12,CV_8UC3));
+		for (int i = 0; i < whole.rows; ++i) for (int j = 0; j < whole.cols; ++j) {
+			whole.at<cv::Vec3b>(i,j) = cv::Vec3b(i * 20,j * 20,(i * j) % 256);
+		}
+		cv::Mat bgr(whole,cv::Rect(2,3,9,5));
+		WHEN("It is converted to Lab") {
+			auto lab = bgr2lab(bgr);
+			THEN("The result has the dimensions of the region of interest and each value is converted correctly") {
+				REQUIRE(lab.rows == 5);
+				REQUIRE(lab.cols == 9);
+				float max = 0;
+				for (int i = 0; i < lab.rows; ++i) for (int j = 0; j < lab.cols; ++j) {
+					auto diff = lab.at<cv::Vec3f>(i,j) - bgr2lab(whole.at<cv::Vec3b>(i + 3,j + 2));
+					for (int k = 0; k < 3; ++k) max = std::max(max,std::abs(diff[k]));
+				}
+				CHECK(max < 0.001f);
+			}
+		}
+	}
+}
+
+SCENARIO("colby::bgr2lab_fast converts RGB points into Lab points using lookup tables","[colby][conversions][bgr2lab_fast]") {
+
+	GIVEN("A sample of RGB colors") {
+		std::vector<cv::Vec3b> colors;
+		for (int b = 0; b < 256; b += 5) for (int g = 0; g < 256; g += 3) for (int r = 0; r < 256; r += 7) {
+			colors.emplace_back(b,g,r);
+		}
+		WHEN("They are converted to Lab") {
+			THEN("Each result is within a Delta E of 0.01 of the result of colby::bgr2lab") {
+				float max = 0;
+				for (auto && c : colors) {
+					auto diff = bgr2lab_fast(c) - bgr2lab(c);
+					max = std::max(max,std::sqrt(diff.dot(diff)));
+				}
+				CHECK(max < 0.01f);
+			}
+		}
+	}
+
+	GIVEN("A cv::Mat with a limited palette") {
+		cv::Mat bgr(20,30,CV_8UC3);
+		for (int i = 0; i < bgr.rows; ++i) for (int j = 0; j < bgr.cols; ++j) {
+			bgr.at<cv::Vec3b>(i,j) = cv::Vec3b((i / 5) * 60,(j / 10) * 100,145);
+		}
+		WHEN("It is converted to Lab with and without a colby::bgr2lab_cache") {
+			bgr2lab_cache cache(4);
+			auto cached = bgr2lab_fast(bgr,cache);
+			auto uncached = bgr2lab_fast(bgr);
+			THEN("The results are identical to each other and to converting each pixel individually") {
+				bool same = true;
+				for (int i = 0; i < bgr.rows; ++i) for (int j = 0; j < bgr.cols; ++j) {
+					auto expected = bgr2lab_fast(bgr.at<cv::Vec3b>(i,j));
+					same = same && (cached.at<cv::Vec3f>(i,j) == expected) && (uncached.at<cv::Vec3f>(i,j) == expected);
+				}
+				CHECK(same);
+			}
+		}
+	}
+
+	GIVEN("A number of bits outside the range 1 to 24") {
+		THEN("Creating a colby::bgr2lab_cache throws") {
+			CHECK_THROWS_AS(bgr2lab_cache(0),std::logic_error);
+			CHECK_THROWS_AS(bgr2lab_cache(25),std::logic_error);
+			CHECK_THROWS_AS(bgr2lab_cache(64),std::logic_error);
+			CHECK_NOTHROW(bgr2lab_cache(1));
+		}
+	}
+
 }
 
 SCENARIO("colby::lab2bgr converts Lab points into RGB points","[colby][conversions][lab2bgr]") {
@@ -140,6 +239,51 @@ SCENARIO("colby::lab2bgr converts Lab points into RGB points","[colby][conversio
 		}
 	}
 
+	GIVEN("A cv::Mat containing a large sample of Lab values") {
+		cv::Mat lab(41,999,CV_32FC3);
+		for (int i = 0; i < lab.rows; ++i) for (int j = 0; j < lab.cols; ++j) {
+			lab.at<cv::Vec3f>(i,j) = cv::Vec3f(
+				(i * 100.f) / (lab.rows - 1),
+				float(j % 37) * 6.f - 108.f,
+				float(j / 37) * 8.f - 108.f
+			);
+		}
+		WHEN("It is converted to RGB") {
+			auto bgr = lab2bgr(lab);
+			THEN("Each value is within 1 of the result of converting the corresponding pixel individually") {
+				int max = 0;
+				for (int i = 0; i < lab.rows; ++i) for (int j = 0; j < lab.cols; ++j) {
+					auto expected = lab2bgr(lab.at<cv::Vec3f>(i,j));
+					auto actual = bgr.at<cv::Vec3b>(i,j);
+					for (int k = 0; k < 3; ++k) max = std::max(max,std::abs(int(expected[k]) - int(actual[k])));
+				}
+				CHECK(max <= 1);
+			}
+		}
+	}
+
+	GIVEN("A region of interest within a larger cv::Mat of Lab values") {
+		cv::Mat whole(cv::Mat::zeros(10,12,CV_32FC3));
+		for (int i = 0; i < whole.rows; ++i) for (int j = 0; j < whole.cols; ++j) {
+			whole.at<cv::Vec3f>(i,j) = cv::Vec3f(i * 10.f,j * 15.f - 80.f,40.f - j * 7.f);
+		}
+		cv::Mat lab(whole,cv::Rect(1,2,10,7));
+		WHEN("It is converted to RGB") {
+			auto bgr = lab2bgr(lab);
+			THEN("The result has the dimensions of the region of interest and each value is converted correctly") {
+				REQUIRE(bgr.rows == 7);
+				REQUIRE(bgr.cols == 10);
+				int max = 0;
+				for (int i = 0; i < bgr.rows; ++i) for (int j = 0; j < bgr.cols; ++j) {
+					auto expected = lab2bgr(whole.at<cv::Vec3f>(i + 2,j + 1));
+					auto actual = bgr.at<cv::Vec3b>(i,j);
+					for (int k = 0; k < 3; ++k) max = std::max(max,std::abs(int(expected[k]) - int(actual[k])));
+				}
+				CHECK(max <= 1);
+			}
+		}
+	}
+
 }
 
 }
@@ -0,0 +1,179 @@
+#include <colby/kmeans.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/core/matx.hpp>
+#include <opencv2/core/types.hpp>
+#include <opencv2/core/utility.hpp>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+//	Sets the number of threads OpenCV uses for the lifetime
+//	of the object, restoring the previous number afterwards
+class num_threads_guard {
+private:
+	int prev_;
+public:
+	explicit num_threads_guard (int n) : prev_(cv::getNumThreads()) {
+		cv::setNumThreads(n);
+	}
+	num_threads_guard (const num_threads_guard &) = delete;
+	num_threads_guard & operator = (const num_threads_guard &) = delete;
+	~num_threads_guard () noexcept {
+		cv::setNumThreads(prev_);
+	}
+};
+
+SCENARIO("colby::weighted_kmeans clusters weighted points","[colby][kmeans][weighted_kmeans]") {
+	cv::TermCriteria criteria(cv::TermCriteria::EPS|cv::TermCriteria::COUNT,100,0.001);
+	std::vector<int> labels;
+	std::vector<cv::Vec3f> centers;
+	GIVEN("Two well separated groups of points") {
+		std::vector<cv::Vec3f> points{
+			cv::Vec3f(0,0,0),
+			cv::Vec3f(1,0,0),
+			cv::Vec3f(100,100,100),
+			cv::Vec3f(100,101,100)
+		};
+		std::vector<double> weights{1,3,2,2};
+		WHEN("They are divided into two clusters") {
+			auto compactness = weighted_kmeans(points,weights,2,criteria,10,labels,centers,1234);
+			THEN("Each group forms a cluster") {
+				REQUIRE(labels.size() == points.size());
+				REQUIRE(centers.size() == 2);
+				CHECK(labels[0] == labels[1]);
+				CHECK(labels[2] == labels[3]);
+				CHECK(labels[0] != labels[2]);
+			}
+			THEN("The center of each cluster is the weighted mean of its points") {
+				auto && a = centers[labels[0]];
+				CHECK(a[0] == Approx(0.75f));
+				CHECK(a[1] == Approx(0.f));
+				auto && b = centers[labels[2]];
+				CHECK(b[0] == Approx(100.f));
+				CHECK(b[1] == Approx(100.5f));
+			}
+			THEN("The compactness is weighted") {
+				//	1 * 0.75^2 + 3 * 0.25^2 + 2 * 0.5^2 + 2 * 0.5^2
+				CHECK(compactness == Approx(1.75));
+			}
+		}
+	}
+	GIVEN("Many scattered points") {
+		std::vector<cv::Vec3f> points;
+		std::vector<double> weights;
+		for (int i = 0; i < 500; ++i) {
+			points.emplace_back(float((i * 37) % 101),float((i * 53) % 89) - 40.f,float((i * i) % 61) - 30.f);
+			weights.push_back(double(1 + (i % 7)));
+		}
+		WHEN("They are clustered") {
+			auto compactness = weighted_kmeans(points,weights,8,criteria,6,labels,centers,42);
+			THEN("Each point belongs to the cluster with the nearest center") {
+				REQUIRE(labels.size() == points.size());
+				REQUIRE(centers.size() == 8);
+				auto distance = [] (const cv::Vec3f & a, const cv::Vec3f & b) {
+					cv::Vec3d d(a - b);
+					return std::sqrt(d.dot(d));
+				};
+				bool nearest = true;
+				double expected = 0;
+				for (std::size_t i = 0; i < points.size(); ++i) {
+					auto d = distance(points[i],centers[labels[i]]);
+					for (auto && c : centers) if (distance(points[i],c) < d - 0.0001) nearest = false;
+					expected += weights[i] * d * d;
+				}
+				CHECK(nearest);
+				CHECK(compactness == Approx(expected).epsilon(0.0001));
+			}
+			AND_WHEN("They are clustered again with the same seed") {
+				std::vector<int> other_labels;
+				std::vector<cv::Vec3f> other_centers;
+				auto other = weighted_kmeans(points,weights,8,criteria,6,other_labels,other_centers,42);
+				THEN("The result is identical") {
+					CHECK(other == compactness);
+					CHECK(other_labels == labels);
+					CHECK(other_centers == centers);
+				}
+			}
+			AND_WHEN("They are clustered again with the same seed on a single thread") {
+				std::vector<int> other_labels;
+				std::vector<cv::Vec3f> other_centers;
+				double other;
+				int threads = cv::getNumThreads();
+				{
+					num_threads_guard guard(1);
+					other = weighted_kmeans(points,weights,8,criteria,6,other_labels,other_centers,42);
+				}
+				THEN("The result is identical") {
+					CHECK(other == compactness);
+					CHECK(other_labels == labels);
+					CHECK(other_centers == centers);
+				}
+				THEN("The number of threads is restored") {
+					CHECK(cv::getNumThreads() == threads);
+				}
+			}
+		}
+	}
+	GIVEN("Points of integer weights and the same points each repeated as many times as its weight") {
+		std::vector<cv::Vec3f> points;
+		std::vector<double> weights;
+		std::vector<cv::Vec3f> repeated;
+		for (int i = 0; i < 60; ++i) {
+			cv::Vec3f p(float((i * 37) % 41),float((i * 11) % 23) - 10.f,float((i * i) % 17));
+			int w = 1 + ((i * 5) % 4);
+			points.push_back(p);
+			weights.push_back(double(w));
+			for (int j = 0; j < w; ++j) repeated.push_back(p);
+		}
+		std::vector<double> ones(repeated.size(),1);
+		WHEN("Both are clustered with the same seed") {
+			auto compactness = weighted_kmeans(points,weights,5,criteria,4,labels,centers,7);
+			std::vector<int> repeated_labels;
+			std::vector<cv::Vec3f> repeated_centers;
+			auto repeated_compactness = weighted_kmeans(repeated,ones,5,criteria,4,repeated_labels,repeated_centers,7);
+			THEN("Each repetition of a point belongs to the cluster of the weighted point") {
+				REQUIRE(repeated_labels.size() == repeated.size());
+				bool same = true;
+				std::size_t r = 0;
+				for (std::size_t i = 0; i < points.size(); ++i) for (int j = 0; j < int(weights[i]); ++j, ++r) if (repeated_labels[r] != labels[i]) same = false;
+				CHECK(same);
+			}
+			THEN("The centers and compactness are the same") {
+				REQUIRE(repeated_centers.size() == centers.size());
+				for (std::size_t c = 0; c < centers.size(); ++c) for (int i = 0; i < 3; ++i) CHECK(repeated_centers[c][i] == Approx(centers[c][i]));
+				CHECK(repeated_compactness == Approx(compactness));
+			}
+		}
+	}
+	GIVEN("No more points than clusters") {
+		std::vector<cv::Vec3f> points{cv::Vec3f(1,2,3),cv::Vec3f(4,5,6)};
+		std::vector<double> weights{5,1};
+		WHEN("They are clustered") {
+			auto compactness = weighted_kmeans(points,weights,3,criteria,10,labels,centers,1234);
+			THEN("Each point forms its own cluster") {
+				REQUIRE(labels.size() == 2);
+				CHECK(labels[0] == 0);
+				CHECK(labels[1] == 1);
+				CHECK(centers == points);
+				CHECK(compactness == 0);
+			}
+		}
+	}
+	GIVEN("A mismatched number of weights") {
+		std::vector<cv::Vec3f> points{cv::Vec3f(1,2,3),cv::Vec3f(4,5,6)};
+		std::vector<double> weights{1};
+		THEN("Clustering them throws") {
+			CHECK_THROWS_AS(weighted_kmeans(points,weights,1,criteria,1,labels,centers,1234),std::logic_error);
+		}
+	}
+}
+
+}
+}
+}
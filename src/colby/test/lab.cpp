@@ -0,0 +1,92 @@
+#include <colby/conversions.hpp>
+#include <colby/lab.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+SCENARIO("colby::lab2fixed and colby::fixed2lab convert between floating point and fixed point CIELAB","[colby][lab][lab2fixed][fixed2lab]") {
+	GIVEN("A sample of CIELAB colors") {
+		cv::Mat lab(50,60,CV_32FC3);
+		for (int i = 0; i < lab.rows; ++i) for (int j = 0; j < lab.cols; ++j) {
+			lab.at<cv::Vec3f>(i,j) = cv::Vec3f(i * 2.0137f,j * 3.7f - 110.f,(i * j) * 0.0731f - 108.f);
+		}
+		WHEN("They are converted to fixed point and back") {
+			auto fixed = lab2fixed(lab);
+			auto round_trip = fixed2lab(fixed);
+			THEN("Each channel is within half a fixed point unit of the original") {
+				REQUIRE(fixed.type() == CV_16SC3);
+				float max = 0;
+				for (int i = 0; i < lab.rows; ++i) for (int j = 0; j < lab.cols; ++j) {
+					auto diff = round_trip.at<cv::Vec3f>(i,j) - lab.at<cv::Vec3f>(i,j);
+					for (int k = 0; k < 3; ++k) max = std::max(max,std::abs(diff[k]));
+				}
+				CHECK(max <= (0.5f / fixed_lab_scale));
+			}
+		}
+	}
+}
+
+SCENARIO("colby::squared_distance agrees for floating point and fixed point CIELAB","[colby][lab][squared_distance]") {
+	GIVEN("Two colors representable exactly in fixed point") {
+		cv::Vec3f a(50.5f,-20.25f,13.015625f);
+		cv::Vec3f b(47.f,-12.75f,10.f);
+		WHEN("The squared distance between them is computed in both representations") {
+			auto f = squared_distance(a,b);
+			auto i = squared_distance(lab2fixed(a),lab2fixed(b));
+			THEN("The results agree") {
+				CHECK(std::abs((i / (fixed_lab_scale * fixed_lab_scale)) - f) < 0.0001f);
+			}
+			THEN("Comparisons against converted thresholds agree") {
+				using traits = lab_traits<cv::Vec3s>;
+				CHECK(i < traits::from_squared_distance(f + 0.01f));
+				CHECK_FALSE(i < traits::from_squared_distance(f));
+			}
+		}
+	}
+}
+
+SCENARIO("The cv::Mat color conversions support fixed point CIELAB","[colby][lab][conversions]") {
+	GIVEN("A cv::Mat of RGB values") {
+		cv::Mat bgr(17,23,CV_8UC3);
+		for (int i = 0; i < bgr.rows; ++i) for (int j = 0; j < bgr.cols; ++j) {
+			bgr.at<cv::Vec3b>(i,j) = cv::Vec3b(i * 15,j * 11,(i * j) % 256);
+		}
+		WHEN("It is converted to fixed point CIELAB") {
+			auto fixed = bgr2lab(bgr,CV_16S);
+			auto lab = bgr2lab(bgr);
+			THEN("The result is the floating point result rounded to fixed point") {
+				REQUIRE(fixed.type() == CV_16SC3);
+				int max = 0;
+				for (int i = 0; i < bgr.rows; ++i) for (int j = 0; j < bgr.cols; ++j) {
+					auto expected = lab2fixed(lab.at<cv::Vec3f>(i,j));
+					auto actual = fixed.at<cv::Vec3s>(i,j);
+					for (int k = 0; k < 3; ++k) max = std::max(max,std::abs(int(expected[k]) - int(actual[k])));
+				}
+				CHECK(max == 0);
+			}
+			AND_WHEN("It is converted back to RGB") {
+				auto round_trip = lab2bgr(fixed);
+				THEN("Each value is within 1 of the original") {
+					int max = 0;
+					for (int i = 0; i < bgr.rows; ++i) for (int j = 0; j < bgr.cols; ++j) {
+						auto expected = bgr.at<cv::Vec3b>(i,j);
+						auto actual = round_trip.at<cv::Vec3b>(i,j);
+						for (int k = 0; k < 3; ++k) max = std::max(max,std::abs(int(expected[k]) - int(actual[k])));
+					}
+					CHECK(max <= 1);
+				}
+			}
+		}
+	}
+}
+
+}
+}
+}
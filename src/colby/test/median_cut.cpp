@@ -0,0 +1,84 @@
+#include <colby/median_cut.hpp>
+#include <opencv2/core/matx.hpp>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+SCENARIO("colby::median_cut chooses a palette for weighted points","[colby][median_cut]") {
+	std::vector<int> labels;
+	std::vector<cv::Vec3f> palette;
+	GIVEN("Three well separated groups of points") {
+		std::vector<cv::Vec3f> points{
+			cv::Vec3f(0,0,0),
+			cv::Vec3f(2,0,0),
+			cv::Vec3f(50,50,0),
+			cv::Vec3f(50,52,0),
+			cv::Vec3f(-50,0,80),
+			cv::Vec3f(-50,0,80)
+		};
+		std::vector<double> weights{3,1,1,1,2,5};
+		WHEN("A palette of three colors is chosen") {
+			auto error = median_cut(points,weights,3,labels,palette);
+			THEN("Each group is assigned a color") {
+				REQUIRE(palette.size() == 3);
+				REQUIRE(labels.size() == points.size());
+				CHECK(labels[0] == labels[1]);
+				CHECK(labels[2] == labels[3]);
+				CHECK(labels[4] == labels[5]);
+				std::set<int> distinct{labels[0],labels[2],labels[4]};
+				CHECK(distinct.size() == 3);
+			}
+			THEN("Each color is the weighted mean of its group") {
+				auto && a = palette[labels[0]];
+				CHECK(a[0] == Approx(0.5f));
+				auto && b = palette[labels[2]];
+				CHECK(b[1] == Approx(51.f));
+				auto && c = palette[labels[4]];
+				CHECK(c[0] == Approx(-50.f));
+				CHECK(c[2] == Approx(80.f));
+			}
+			THEN("The error is weighted") {
+				//	3 * 0.5^2 + 1 * 1.5^2 + 1 * 1^2 + 1 * 1^2
+				CHECK(error == Approx(5.));
+			}
+			AND_WHEN("The palette is chosen again") {
+				std::vector<int> other_labels;
+				std::vector<cv::Vec3f> other_palette;
+				median_cut(points,weights,3,other_labels,other_palette);
+				THEN("The result is identical") {
+					CHECK(other_labels == labels);
+					CHECK(other_palette == palette);
+				}
+			}
+		}
+	}
+	GIVEN("Fewer distinct points than colors") {
+		std::vector<cv::Vec3f> points{cv::Vec3f(1,2,3),cv::Vec3f(4,5,6),cv::Vec3f(1,2,3)};
+		std::vector<double> weights{1,1,1};
+		WHEN("A palette is chosen") {
+			auto error = median_cut(points,weights,5,labels,palette);
+			THEN("There is one color per distinct point") {
+				REQUIRE(palette.size() == 2);
+				CHECK(labels[0] == labels[2]);
+				CHECK(labels[0] != labels[1]);
+				CHECK(error == 0);
+			}
+		}
+	}
+	GIVEN("A mismatched number of weights") {
+		std::vector<cv::Vec3f> points{cv::Vec3f(1,2,3)};
+		std::vector<double> weights{1,2};
+		THEN("Choosing a palette throws") {
+			CHECK_THROWS_AS(median_cut(points,weights,1,labels,palette),std::logic_error);
+		}
+	}
+}
+
+}
+}
+}
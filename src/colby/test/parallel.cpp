@@ -0,0 +1,48 @@
+#include <colby/parallel.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <atomic>
+#include <vector>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+SCENARIO("colby::parallel_for invokes a callback for disjoint subranges which cover a range","[colby][parallel][parallel_for]") {
+	GIVEN("A range") {
+		cv::Range range(3,1003);
+		WHEN("colby::parallel_for is called thereupon") {
+			std::vector<std::atomic<int>> counts(1003);
+			for (auto && c : counts) c = 0;
+			parallel_for(range,[&] (const cv::Range & r) {
+				for (int i = r.start; i < r.end; ++i) ++counts[i];
+			});
+			THEN("Each index in the range is visited exactly once") {
+				bool once = true;
+				for (int i = 0; i < 1003; ++i) once = once && (counts[i] == ((i < 3) ? 0 : 1));
+				CHECK(once);
+			}
+		}
+	}
+}
+
+SCENARIO("colby::parallel_rows invokes a callback for each row of a cv::Mat","[colby][parallel][parallel_rows]") {
+	GIVEN("An image") {
+		cv::Mat mat(cv::Mat::zeros(257,3,CV_32SC1));
+		WHEN("colby::parallel_rows is called thereupon") {
+			parallel_rows(mat,[&] (int i) {
+				for (int j = 0; j < mat.cols; ++j) mat.at<int>(i,j) += i;
+			});
+			THEN("Each row is visited exactly once") {
+				bool once = true;
+				for (int i = 0; i < mat.rows; ++i) for (int j = 0; j < mat.cols; ++j) once = once && (mat.at<int>(i,j) == i);
+				CHECK(once);
+			}
+		}
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,406 @@
+#include <colby/algorithm.hpp>
+#include <colby/components.hpp>
+#include <colby/region_graph.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+using graph_type = region_graph<cv::Vec3f>;
+
+//	An image of 3 rows of 4 square blocks of 4x4 pixels,
+//	each block being a region, of noisy colors
+cv::Mat make_image () {
+	cv::Mat retr(12,16,CV_32FC3);
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> noise(-3.f,3.f);
+	for (int i = 0; i < retr.rows; ++i) for (int j = 0; j < retr.cols; ++j) {
+		auto block = float(((i / 4) * 4) + (j / 4));
+		retr.at<cv::Vec3f>(i,j) = cv::Vec3f((block * 7.f) + noise(rng),(block * -3.f) + noise(rng),noise(rng));
+	}
+	return retr;
+}
+
+cv::Mat make_labels () {
+	cv::Mat retr(12,16,CV_32SC1);
+	for (int i = 0; i < retr.rows; ++i) for (int j = 0; j < retr.cols; ++j) retr.at<int>(i,j) = ((i / 4) * 4) + (j / 4);
+	return retr;
+}
+
+//	Checks that a graph (including the border and gradient
+//	of each edge) is that which would be built from scratch
+//	from the regions it currently represents.  The
+//	vertices of the fresh graph are the positions of the
+//	vertices of the graph within vertices()
+void check_fresh (const graph_type & g, const cv::Mat & img, bool diagonal) {
+	std::vector<cv::Vec3f> palette;
+	auto labels = g.labels(palette);
+	graph_type fresh(img,labels,int(g.size()),diagonal);
+	auto && vertices = g.vertices();
+	REQUIRE(fresh.size() == vertices.size());
+	std::vector<int> positions(g.owners().size(),-1);
+	for (std::size_t k = 0; k < vertices.size(); ++k) positions[vertices[k]] = int(k);
+	for (std::size_t k = 0; k < vertices.size(); ++k) {
+		auto v = vertices[k];
+		auto f = int(k);
+		CHECK(g.size(v) == fresh.size(f));
+		for (int c = 0; c < 3; ++c) {
+			CHECK(g.sum(v)[c] == Approx(fresh.sum(f)[c]));
+			CHECK(g.color(v)[c] == Approx(fresh.color(f)[c]));
+		}
+		auto && ns = g.neighbors(v);
+		auto && fresh_ns = fresh.neighbors(f);
+		REQUIRE(ns.size() == fresh_ns.size());
+		std::vector<graph_type::edge> edges;
+		for (auto e : ns) {
+			e.to = positions[e.to];
+			edges.push_back(e);
+		}
+		std::sort(edges.begin(),edges.end(),[] (const graph_type::edge & a, const graph_type::edge & b) noexcept {
+			return a.to < b.to;
+		});
+		for (std::size_t l = 0; l < edges.size(); ++l) {
+			CHECK(edges[l].to == fresh_ns[l].to);
+			CHECK(edges[l].border == fresh_ns[l].border);
+			CHECK(edges[l].gradient == Approx(fresh_ns[l].gradient));
+		}
+	}
+}
+
+SCENARIO("colby::region_graph maintains its vertices and edges as vertices are merged","[colby][region_graph]") {
+	auto img = make_image();
+	for (bool diagonal : {false,true}) {
+		GIVEN((diagonal ? "A graph of blocks with eight connectivity" : "A graph of blocks with four connectivity")) {
+			graph_type g(img,make_labels(),12,diagonal);
+			THEN("Each block is a vertex") {
+				CHECK(g.size() == 12);
+				CHECK(g.size(0) == 16);
+				CHECK(g.neighbors(5).size() == (diagonal ? 8U : 4U));
+			}
+			WHEN("Neighboring vertices are merged") {
+				std::vector<std::pair<int,int>> merges{{1,0},{1,5},{6,7},{6,2},{10,11},{9,10},{1,6},{4,8}};
+				for (auto && m : merges) g.merge(m.first,m.second);
+				THEN("The graph is that which would be built from the merged regions") {
+					CHECK(g.size() == 4);
+					CHECK(g.merges() == merges.size());
+					check_fresh(g,img,diagonal);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("colby::region_graph resolves the owner of every vertex","[colby][region_graph]") {
+	GIVEN("A graph of a strip of single pixel regions") {
+		cv::Mat img(1,200,CV_32FC3,cv::Scalar(1,2,3));
+		cv::Mat labels(1,200,CV_32SC1);
+		for (int j = 0; j < labels.cols; ++j) labels.at<int>(0,j) = j;
+		graph_type g(img,labels,200,false);
+		WHEN("Each region is merged into its predecessor from the end of the strip") {
+			for (int v = 199; v > 0; --v) g.merge(v - 1,v);
+			THEN("Every vertex is owned by the first") {
+				auto owners = g.owners();
+				REQUIRE(owners.size() == 200U);
+				bool all = true;
+				for (auto v : owners) if (v != 0) all = false;
+				CHECK(all);
+				CHECK(g.size(0) == 200U);
+			}
+		}
+		WHEN("Regions are merged into their successors") {
+			for (int v = 0; v < 199; v += 2) g.merge(v + 1,v);
+			THEN("Each pair is owned by its second vertex") {
+				auto owners = g.owners();
+				bool paired = true;
+				for (int v = 0; v < 200; ++v) if (owners[v] != (v | 1)) paired = false;
+				CHECK(paired);
+			}
+		}
+	}
+}
+
+//	Merges the pair of neighboring vertices of least weight
+//	by examining every edge, breaking ties as n_merge does
+void brute_force_n_merge_step (graph_type & g) {
+	bool found = false;
+	float best = 0;
+	graph_type::neighbors_type pair;
+	for (auto a : g.vertices()) for (auto && e : g.neighbors(a)) {
+		if (e.to < a) continue;
+		auto candidate = std::make_pair(a,e.to);
+		auto weight = detail::n_merge_weight(g,candidate);
+		if (found && (std::make_tuple(weight,candidate.first,candidate.second) >= std::make_tuple(best,pair.first,pair.second))) continue;
+		found = true;
+		best = weight;
+		pair = candidate;
+	}
+	REQUIRE(found);
+	g.merge(pair.first,pair.second);
+}
+
+//	Checks that n_merge merges the same pairs in the same
+//	order as a brute force search by comparing the graphs
+//	after every number of merges
+void check_n_merge (const cv::Mat & img, const cv::Mat & labels, int n) {
+	graph_type expected(img,labels,n,false);
+	for (std::size_t target = std::size_t(n) - 1; target > 0; --target) {
+		brute_force_n_merge_step(expected);
+		graph_type g(img,labels,n,false);
+		n_merge(g,target);
+		REQUIRE(g.size() == target);
+		REQUIRE(g.owners() == expected.owners());
+		for (auto v : g.vertices()) REQUIRE(g.color(v) == expected.color(v));
+	}
+}
+
+SCENARIO("colby::n_merge always merges the pair of neighboring regions of least weight","[colby][region_graph][n_merge]") {
+	GIVEN("A graph of noisy blocks") {
+		THEN("Merges occur in the same order as with a brute force search") {
+			check_n_merge(make_image(),make_labels(),12);
+		}
+	}
+	GIVEN("A graph of blocks of the same size and of few colors such that many weights are equal") {
+		cv::Mat img(12,18,CV_32FC3);
+		cv::Mat labels(12,18,CV_32SC1);
+		for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+			auto block = ((i / 3) * 6) + (j / 3);
+			labels.at<int>(i,j) = block;
+			auto c = float(((block * 5) % 7) % 3);
+			img.at<cv::Vec3f>(i,j) = cv::Vec3f(c * 10.f,c * 4.f,0);
+		}
+		THEN("Merges occur in the same order as with a brute force search") {
+			check_n_merge(img,labels,24);
+		}
+	}
+}
+
+//	A strip one pixel high of runs of certain lengths, each
+//	run being a region of a distinct color
+void make_strip (const std::vector<int> & runs, cv::Mat & img, cv::Mat & labels) {
+	int cols = 0;
+	for (auto run : runs) cols += run;
+	img.create(1,cols,CV_32FC3);
+	labels.create(1,cols,CV_32SC1);
+	int j = 0;
+	for (std::size_t r = 0; r < runs.size(); ++r) for (int k = 0; k < runs[r]; ++k, ++j) {
+		labels.at<int>(0,j) = int(r);
+		img.at<cv::Vec3f>(0,j) = cv::Vec3f(float(r) * 5.f,0,0);
+	}
+}
+
+SCENARIO("colby::merge_small_cells merges every region at or below a threshold","[colby][region_graph][merge_small_cells]") {
+	GIVEN("A graph of regions of several sizes at and below the threshold") {
+		//	Merging the smallest regions grows their neighbors,
+		//	some of which remain at or below the threshold and
+		//	must be merged again
+		std::vector<int> runs{20,1,2,3,3,5,6,2,7,1,4,1,1,30};
+		cv::Mat img;
+		cv::Mat labels;
+		make_strip(runs,img,labels);
+		graph_type g(img,labels,int(runs.size()),false);
+		WHEN("Small regions are merged") {
+			merge_small_cells(g,6);
+			THEN("No region at or below the threshold remains") {
+				bool small = false;
+				for (auto v : g.vertices()) if (g.size(v) <= 6U) small = true;
+				CHECK_FALSE(small);
+			}
+			THEN("Every pixel is still owned") {
+				std::size_t total = 0;
+				for (auto v : g.vertices()) total += g.size(v);
+				CHECK(total == std::size_t(img.cols));
+			}
+			THEN("The graph is that which would be built from the merged regions") {
+				check_fresh(g,img,false);
+			}
+		}
+		WHEN("Small regions are merged without averaging colors") {
+			merge_small_cells(g,6,false);
+			THEN("Each remaining region has the color of one of the original regions") {
+				bool original = true;
+				for (auto v : g.vertices()) {
+					auto c = g.color(v);
+					if ((c[1] != 0) || (c[2] != 0) || (std::fmod(c[0],5.f) != 0)) original = false;
+				}
+				CHECK(original);
+			}
+		}
+	}
+	GIVEN("A graph in which no region is at or below the threshold") {
+		std::vector<int> runs{7,8,9};
+		cv::Mat img;
+		cv::Mat labels;
+		make_strip(runs,img,labels);
+		graph_type g(img,labels,int(runs.size()),false);
+		WHEN("Small regions are merged") {
+			merge_small_cells(g,6);
+			THEN("Nothing is merged") {
+				CHECK(g.size() == 3U);
+				CHECK(g.merges() == 0U);
+			}
+		}
+	}
+}
+
+//	Determines whether any two neighboring regions are at a
+//	squared distance less than a tolerance
+bool any_similar_neighbors (const graph_type & g, float tolerance) {
+	for (auto v : g.vertices()) for (auto && e : g.neighbors(v)) {
+		if (squared_distance(g.color(v),g.color(e.to)) < tolerance) return true;
+	}
+	return false;
+}
+
+SCENARIO("colby::merge_similar_cells merges neighboring regions of similar colors","[colby][region_graph][merge_similar_cells]") {
+	GIVEN("A graph of regions whose colors change gradually") {
+		//	Merging changes the color of the merged region, so
+		//	regions which were not similar may become similar
+		cv::Mat img(8,40,CV_32FC3);
+		cv::Mat labels(8,40,CV_32SC1);
+		std::mt19937 rng(11);
+		std::uniform_real_distribution<float> step(0.5f,3.f);
+		float l = 0;
+		for (int j = 0; j < img.cols; ++j) {
+			l += step(rng);
+			for (int i = 0; i < img.rows; ++i) {
+				labels.at<int>(i,j) = ((i / 4) * img.cols) + j;
+				img.at<cv::Vec3f>(i,j) = cv::Vec3f(l,(i < 4) ? 0.f : 2.f,0);
+			}
+		}
+		graph_type g(img,labels,img.cols * 2,false);
+		REQUIRE(any_similar_neighbors(g,5.f));
+		WHEN("Similar regions are merged") {
+			merge_similar_cells(g,5.f);
+			THEN("No two neighboring regions are within the tolerance of one another") {
+				CHECK(g.size() < std::size_t(img.cols * 2));
+				CHECK_FALSE(any_similar_neighbors(g,5.f));
+			}
+			THEN("The graph is that which would be built from the merged regions") {
+				check_fresh(g,img,false);
+			}
+		}
+	}
+	GIVEN("A graph wherein a merge makes a region similar to a neighbor which has already been examined") {
+		//	The largest region is examined first and is not
+		//	similar to its neighbor, which becomes similar to
+		//	it once it absorbs the region on its other side
+		std::vector<int> runs{10,5,4,3};
+		std::vector<float> colors{0,3,1,50};
+		cv::Mat img;
+		cv::Mat labels;
+		make_strip(runs,img,labels);
+		for (int j = 0; j < img.cols; ++j) img.at<cv::Vec3f>(0,j) = cv::Vec3f(colors[labels.at<int>(0,j)],0,0);
+		graph_type g(img,labels,int(runs.size()),false);
+		WHEN("Similar regions are merged") {
+			merge_similar_cells(g,5.f);
+			THEN("No two neighboring regions are within the tolerance of one another") {
+				CHECK(g.size() == 2U);
+				CHECK_FALSE(any_similar_neighbors(g,5.f));
+			}
+		}
+	}
+	GIVEN("A graph of noisy blocks") {
+		auto img = make_image();
+		graph_type g(img,make_labels(),12,true);
+		WHEN("Similar regions are merged with a large tolerance") {
+			merge_similar_cells(g,150.f);
+			THEN("No two neighboring regions are within the tolerance of one another") {
+				CHECK(g.size() < 12U);
+				CHECK_FALSE(any_similar_neighbors(g,150.f));
+			}
+		}
+	}
+}
+
+
+//	An image of indices into a palette of four colors made
+//	of blocks of 6x8 pixels, and a second image wherein
+//	rectangles and a column have been painted over the
+//	first so that many regions are split
+std::pair<cv::Mat,cv::Mat> make_indices (unsigned seed) {
+	std::mt19937 rng(seed);
+	cv::Mat a(24,32,CV_8UC1);
+	for (int i = 0; i < a.rows; ++i) for (int j = 0; j < a.cols; ++j) {
+		a.at<std::uint8_t>(i,j) = std::uint8_t(((i / 6) * 5 + (j / 8) * 3 + seed) % 4);
+	}
+	auto b = a.clone();
+	for (int r = 0; r < 6; ++r) {
+		int i0 = int(rng() % 22);
+		int j0 = int(rng() % 30);
+		int rows = 1 + int(rng() % 3);
+		int cols = 1 + int(rng() % 5);
+		auto index = std::uint8_t(rng() % 4);
+		for (int i = i0; (i < (i0 + rows)) && (i < b.rows); ++i) for (int j = j0; (j < (j0 + cols)) && (j < b.cols); ++j) b.at<std::uint8_t>(i,j) = index;
+	}
+	int column = int(rng() % 32);
+	for (int i = 0; i < b.rows; ++i) b.at<std::uint8_t>(i,column) = std::uint8_t((b.at<std::uint8_t>(i,column) + 1) % 4);
+	return std::make_pair(a,b);
+}
+
+//	Resegments a graph built from one image of indices
+//	(and then partially merged) to another and checks that
+//	it is identical to a graph built afresh from the latter,
+//	including the number of each vertex
+template <typename Neighborhood>
+void check_resegment (const cv::Mat & a, const cv::Mat & b, bool diagonal) {
+	std::vector<cv::Vec3f> palette{{0,0,0},{10,20,30},{40,-10,5},{-25,15,60}};
+	cv::Mat labels;
+	auto n = label_equal_components<std::uint8_t,Neighborhood>(a,labels);
+	graph_type g(a,palette,labels,n,diagonal);
+	n_merge(g,g.size() / 2,false);
+	g.resegment<Neighborhood>(b,palette);
+	cv::Mat fresh_labels;
+	auto fresh_n = label_equal_components<std::uint8_t,Neighborhood>(b,fresh_labels);
+	graph_type fresh(b,palette,fresh_labels,fresh_n,diagonal);
+	REQUIRE(g.size() == fresh.size());
+	CHECK(g.vertices() == fresh.vertices());
+	std::vector<cv::Vec3f> ignored;
+	auto g_labels = g.labels(ignored);
+	bool same = true;
+	for (int i = 0; i < b.rows; ++i) for (int j = 0; j < b.cols; ++j) if (g_labels.at<int>(i,j) != fresh_labels.at<int>(i,j)) same = false;
+	CHECK(same);
+	for (auto v : fresh.vertices()) {
+		CHECK(g.size(v) == fresh.size(v));
+		CHECK(g.color(v) == fresh.color(v));
+		auto && ns = g.neighbors(v);
+		auto && fresh_ns = fresh.neighbors(v);
+		REQUIRE(ns.size() == fresh_ns.size());
+		for (std::size_t l = 0; l < ns.size(); ++l) {
+			CHECK(ns[l].to == fresh_ns[l].to);
+			CHECK(ns[l].border == fresh_ns[l].border);
+			CHECK(ns[l].gradient == Approx(fresh_ns[l].gradient));
+		}
+	}
+}
+
+SCENARIO("colby::region_graph may be resegmented such that it is identical to a graph created afresh","[colby][region_graph][resegment]") {
+	GIVEN("Pairs of images of indices wherein the second splits many regions of the first") {
+		std::vector<std::pair<cv::Mat,cv::Mat>> images;
+		for (unsigned seed : {1U,2U,3U}) images.push_back(make_indices(seed));
+		WHEN("Graphs with four connectivity are resegmented") {
+			THEN("Each is identical to a graph created afresh") {
+				for (auto && p : images) check_resegment<four_neighborhood>(p.first,p.second,false);
+			}
+		}
+		WHEN("Graphs with eight connectivity are resegmented") {
+			THEN("Each is identical to a graph created afresh") {
+				for (auto && p : images) check_resegment<eight_neighborhood>(p.first,p.second,true);
+			}
+		}
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,67 @@
+#include <colby/smooth.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <stdexcept>
+#include <vector>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+SCENARIO("colby::smooth_labels smooths a label map without introducing new colors","[colby][smooth][smooth_labels]") {
+	std::vector<cv::Vec3f> palette{cv::Vec3f(20,0,0),cv::Vec3f(80,10,-10),cv::Vec3f(50,-40,40)};
+	GIVEN("An image divided into two halves with a speck of a third color") {
+		cv::Mat labels(20,30,CV_32SC1);
+		for (int i = 0; i < labels.rows; ++i) for (int j = 0; j < labels.cols; ++j) labels.at<int>(i,j) = (j < 15) ? 0 : 1;
+		labels.at<int>(10,5) = 2;
+		WHEN("It is smoothed") {
+			auto smoothed = smooth_labels(labels,palette,3);
+			THEN("The result is a label map of the same dimensions") {
+				REQUIRE(smoothed.type() == CV_32SC1);
+				REQUIRE(smoothed.rows == labels.rows);
+				REQUIRE(smoothed.cols == labels.cols);
+			}
+			THEN("The speck takes the color of its surroundings") {
+				CHECK(smoothed.at<int>(10,5) == 0);
+			}
+			THEN("The edge between the halves is preserved") {
+				bool preserved = true;
+				for (int i = 0; i < labels.rows; ++i) for (int j = 0; j < labels.cols; ++j) {
+					if ((i == 10) && (j == 5)) continue;
+					if (smoothed.at<int>(i,j) != labels.at<int>(i,j)) preserved = false;
+				}
+				CHECK(preserved);
+			}
+		}
+	}
+	GIVEN("An image with stripes of alternating colors") {
+		cv::Mat labels(16,40,CV_32SC1);
+		for (int i = 0; i < labels.rows; ++i) for (int j = 0; j < labels.cols; ++j) labels.at<int>(i,j) = (j % 4) < 2 ? 0 : 1;
+		WHEN("It is smoothed with a radius of zero") {
+			auto smoothed = smooth_labels(labels,palette,0);
+			THEN("It is unchanged") {
+				bool unchanged = true;
+				for (int i = 0; i < labels.rows; ++i) for (int j = 0; j < labels.cols; ++j) {
+					if (smoothed.at<int>(i,j) != labels.at<int>(i,j)) unchanged = false;
+				}
+				CHECK(unchanged);
+			}
+		}
+		WHEN("It is smoothed with a radius larger than the image") {
+			auto smoothed = smooth_labels(labels,palette,50);
+			THEN("Each pixel takes one of the colors nearby") {
+				bool nearby = true;
+				for (int i = 0; i < labels.rows; ++i) for (int j = 0; j < labels.cols; ++j) {
+					auto l = smoothed.at<int>(i,j);
+					if ((l != 0) && (l != 1)) nearby = false;
+				}
+				CHECK(nearby);
+			}
+		}
+	}
+}
+
+}
+}
+}
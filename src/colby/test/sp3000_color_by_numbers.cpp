@@ -0,0 +1,273 @@
+#include <colby/algorithm.hpp>
+#include <colby/components.hpp>
+#include <colby/sp3000_color_by_numbers.hpp>
+#include <colby/sp3000_color_by_numbers_observer.hpp>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+//	A BGR image of noisy bands and blobs of several colors
+cv::Mat make_image () {
+	cv::Mat retr(48,64,CV_8UC3);
+	std::mt19937 rng(3);
+	for (int i = 0; i < retr.rows; ++i) for (int j = 0; j < retr.cols; ++j) {
+		int band = ((j / 9) + (i / 7)) % 5;
+		if ((((i - 24) * (i - 24)) + ((j - 30) * (j - 30))) < 80) band = 5;
+		auto noise = [&] () {	return int(rng() % 9);	};
+		retr.at<cv::Vec3b>(i,j) = cv::Vec3b(
+			std::uint8_t((band * 40) + noise()),
+			std::uint8_t(((band * 97) % 200) + noise()),
+			std::uint8_t(((band * 151) % 200) + noise())
+		);
+	}
+	return retr;
+}
+
+//	A BGR image of diagonal bands of blocks of three colors
+//	wherein many pixels have been replaced by random colors,
+//	which smoothing changes such that many regions are split
+cv::Mat make_noisy_image (int rows, unsigned seed) {
+	cv::Mat retr(rows,50,CV_8UC3);
+	std::mt19937 rng(seed);
+	for (int i = 0; i < retr.rows; ++i) for (int j = 0; j < retr.cols; ++j) {
+		int v = ((i / 5) + (j / 5)) % 3;
+		if ((rng() % 5) == 0) v = int(rng() % 3);
+		retr.at<cv::Vec3b>(i,j) = cv::Vec3b(std::uint8_t(v * 40),std::uint8_t((v * 97) % 255),std::uint8_t((v * 151) % 255));
+	}
+	return retr;
+}
+
+bool equal (const cv::Mat & a, const cv::Mat & b) {
+	if ((a.rows != b.rows) || (a.cols != b.cols) || (a.type() != b.type())) return false;
+	for (int i = 0; i < a.rows; ++i) for (int j = 0; j < a.cols; ++j) if (a.at<cv::Vec3b>(i,j) != b.at<cv::Vec3b>(i,j)) return false;
+	return true;
+}
+
+std::size_t count_colors (const cv::Mat & img) {
+	std::set<std::tuple<int,int,int>> colors;
+	for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+		auto c = img.at<cv::Vec3b>(i,j);
+		colors.emplace(c[0],c[1],c[2]);
+	}
+	return colors.size();
+}
+
+//	Each region is connected and of a single color, so
+//	each connected group of pixels of the same color is
+//	one or more regions
+template <typename Neighborhood>
+int count_regions (const cv::Mat & img) {
+	cv::Mat packed(img.rows,img.cols,CV_32SC1);
+	for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+		auto c = img.at<cv::Vec3b>(i,j);
+		packed.at<int>(i,j) = int(c[0]) | (int(c[1]) << 8) | (int(c[2]) << 16);
+	}
+	cv::Mat labels;
+	return label_equal_components<int,Neighborhood>(packed,labels);
+}
+
+class recording_observer : public sp3000_color_by_numbers_observer {
+private:
+	void record (std::string name, base_event e) {
+		names.push_back(std::move(name));
+		statistics.push_back(e.statistics());
+		auto img = e.image();
+		regions.push_back(count_regions<four_neighborhood>(img));
+		images.push_back(img);
+		snapshots.push_back(e.snapshot());
+	}
+public:
+	std::vector<std::string> names;
+	std::vector<stage_statistics> statistics;
+	std::vector<cv::Mat> images;
+	std::vector<base_event> snapshots;
+	//	The number of connected groups of pixels of the
+	//	same color in the image of each event
+	std::vector<int> regions;
+	virtual void flood_fill (flood_fill_event e) override {
+		record("flood_fill",e);
+	}
+	virtual void merge_small_cells (merge_small_cells_event e) override {
+		record("merge_small_cells",e);
+	}
+	virtual void merge_similar_cells (merge_similar_cells_event e) override {
+		record("merge_similar_cells",e);
+	}
+	virtual void n_merge (n_merge_event e) override {
+		record("n_merge",e);
+	}
+	virtual void p_merge (p_merge_event e) override {
+		record("p_merge",e);
+	}
+	virtual void gaussian_smooth (gaussian_smooth_event e) override {
+		record("gaussian_smooth",e);
+	}
+};
+
+SCENARIO("colby::sp3000_color_by_numbers limits the number of regions and colors","[colby][sp3000_color_by_numbers]") {
+	auto img = make_image();
+	sp3000_color_by_numbers::options opts;
+	GIVEN("Options with four connectivity") {
+		opts.neighborhood = sp3000_color_by_numbers::connectivity::four;
+		sp3000_color_by_numbers impl(12,4,10.f,10,5.f,opts);
+		WHEN("An image is converted") {
+			auto result = impl.convert(img).image();
+			THEN("The result has the dimensions of the image") {
+				REQUIRE(result.type() == CV_8UC3);
+				CHECK(result.rows == img.rows);
+				CHECK(result.cols == img.cols);
+			}
+			THEN("There are at most N regions and P colors") {
+				CHECK(count_regions<four_neighborhood>(result) <= 12);
+				CHECK(count_colors(result) <= 4U);
+			}
+		}
+	}
+	GIVEN("Options with eight connectivity and fixed point colors") {
+		opts.neighborhood = sp3000_color_by_numbers::connectivity::eight;
+		opts.format = sp3000_color_by_numbers::lab_format::fixed_point;
+		sp3000_color_by_numbers impl(8,3,10.f,10,5.f,opts);
+		WHEN("An image is converted") {
+			auto result = impl.convert(img).image();
+			THEN("There are at most N regions and P colors") {
+				CHECK(count_regions<eight_neighborhood>(result) <= 8);
+				CHECK(count_colors(result) <= 3U);
+			}
+		}
+	}
+}
+
+
+SCENARIO("colby::sp3000_color_by_numbers produces the same result whether or not the graph is updated incrementally","[colby][sp3000_color_by_numbers]") {
+	sp3000_color_by_numbers::options opts;
+	auto convert = [&] (const cv::Mat & img, std::size_t n, bool incremental) {
+		opts.incremental = incremental;
+		sp3000_color_by_numbers impl(n,3,10.f,10,5.f,opts);
+		return impl.convert(img).image();
+	};
+	GIVEN("Options with four connectivity") {
+		opts.neighborhood = sp3000_color_by_numbers::connectivity::four;
+		auto img = make_noisy_image(60,2);
+		THEN("The results are identical") {
+			CHECK(equal(convert(img,4,true),convert(img,4,false)));
+		}
+	}
+	GIVEN("Options with eight connectivity and fixed point colors") {
+		opts.neighborhood = sp3000_color_by_numbers::connectivity::eight;
+		opts.format = sp3000_color_by_numbers::lab_format::fixed_point;
+		auto img = make_noisy_image(70,3);
+		THEN("The results are identical") {
+			CHECK(equal(convert(img,10,true),convert(img,10,false)));
+		}
+	}
+}
+
+SCENARIO("colby::sp3000_color_by_numbers reports statistics for each stage","[colby][sp3000_color_by_numbers]") {
+	auto img = make_noisy_image(60,2);
+	for (bool incremental : {false,true}) {
+		GIVEN((incremental ? "An observer of a conversion which updates the graph incrementally" : "An observer of a conversion")) {
+			recording_observer r;
+			sp3000_color_by_numbers::options opts;
+			opts.incremental = incremental;
+			sp3000_color_by_numbers impl(r,12,3,10.f,10,5.f,opts);
+			WHEN("An image is converted") {
+				impl.convert(img);
+				THEN("Every event is delivered in order") {
+					std::vector<std::string> expected{
+						"flood_fill",
+						"merge_small_cells",
+						"merge_similar_cells",
+						"n_merge",
+						"p_merge",
+						"gaussian_smooth",
+						"flood_fill",
+						"merge_small_cells",
+						"n_merge"
+					};
+					CHECK(r.names == expected);
+				}
+				REQUIRE(r.statistics.size() == 9U);
+				auto && s = r.statistics;
+				THEN("The merges of each merging stage are the number of regions it eliminated") {
+					for (std::size_t i : {1U,2U,3U,4U,7U,8U}) {
+						REQUIRE(s[i].regions <= s[i - 1].regions);
+						CHECK(s[i].merges == (s[i - 1].regions - s[i].regions));
+					}
+				}
+				THEN("The regions of each stage are those of its image and within the limits of the stage") {
+					for (std::size_t i = 0; i < s.size(); ++i) CHECK(std::size_t(r.regions[i]) <= s[i].regions);
+					CHECK(s[3].regions <= 18U);
+					CHECK(s[8].regions <= 12U);
+				}
+				THEN("Smoothing and flood filling merge no regions") {
+					CHECK(s[0].merges == 0U);
+					CHECK(s[5].merges == 0U);
+					CHECK(s[5].regions == s[4].regions);
+					CHECK(s[6].merges == 0U);
+				}
+				THEN("Only flood filling and smoothing read every pixel") {
+					for (std::size_t i = 0; i < s.size(); ++i) {
+						bool reads = (i == 0) || (i == 5) || (i == 6);
+						CHECK(s[i].pixels == (reads ? img.total() : 0U));
+					}
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("colby::sp3000_color_by_numbers renders each region in its color","[colby][sp3000_color_by_numbers]") {
+	GIVEN("An image of two flat colors") {
+		cv::Mat img(40,60,CV_8UC3);
+		cv::Vec3b left(30,160,220);
+		cv::Vec3b right(200,80,40);
+		for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) img.at<cv::Vec3b>(i,j) = (j < 25) ? left : right;
+		WHEN("It is converted") {
+			sp3000_color_by_numbers impl(12,4);
+			auto result = impl.convert(img).image();
+			THEN("Each pixel has its original color") {
+				bool same = true;
+				for (int i = 0; i < img.rows; ++i) for (int j = 0; j < img.cols; ++j) {
+					auto a = img.at<cv::Vec3b>(i,j);
+					auto b = result.at<cv::Vec3b>(i,j);
+					for (int c = 0; c < 3; ++c) if (std::abs(int(a[c]) - int(b[c])) > 1) same = false;
+				}
+				CHECK(same);
+			}
+		}
+	}
+	GIVEN("An observer of a conversion") {
+		auto img = make_noisy_image(60,2);
+		recording_observer r;
+		sp3000_color_by_numbers impl(r,12,3);
+		WHEN("An image is converted") {
+			auto result = impl.convert(img).image();
+			REQUIRE(r.images.size() == 9U);
+			THEN("The image of each event is that of its snapshot") {
+				for (std::size_t i = 0; i < r.images.size(); ++i) CHECK(equal(r.images[i],r.snapshots[i].image()));
+			}
+			THEN("The result is the image of the last event") {
+				CHECK(equal(result,r.images.back()));
+			}
+			THEN("The images of the events after P-merging have at most P colors") {
+				for (std::size_t i = 4; i < r.images.size(); ++i) CHECK(count_colors(r.images[i]) <= 3U);
+			}
+		}
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,114 @@
+#include <colby/parallel.hpp>
+#include <colby/union_find.hpp>
+#include <opencv2/core/types.hpp>
+#include <catch.hpp>
+
+namespace colby {
+namespace test {
+namespace {
+
+SCENARIO("colby::union_find tracks a partition of the integers","[colby][union_find]") {
+	GIVEN("A colby::union_find containing singleton sets") {
+		union_find sets(5);
+		THEN("Each element is its own representative") {
+			for (int i = 0; i < 5; ++i) CHECK(sets.find(i) == i);
+		}
+		WHEN("Sets are united") {
+			auto a = sets.unite(3,4);
+			auto b = sets.unite(4,1);
+			THEN("The representative of each united set is its smallest element") {
+				CHECK(a == 3);
+				CHECK(b == 1);
+				CHECK(sets.find(3) == 1);
+				CHECK(sets.find(4) == 1);
+			}
+			THEN("Other sets are unaffected") {
+				CHECK(sets.find(0) == 0);
+				CHECK(sets.find(2) == 2);
+			}
+			THEN("The representatives may be found without modifying the colby::union_find") {
+				const auto & c = sets;
+				CHECK(c.find(4) == 1);
+				CHECK(c.find(0) == 0);
+			}
+		}
+		WHEN("A set is added") {
+			auto i = sets.add();
+			THEN("It contains the next element") {
+				CHECK(i == 5);
+				CHECK(sets.size() == 6U);
+				CHECK(sets.find(5) == 5);
+			}
+		}
+	}
+}
+
+SCENARIO("colby::sized_union_find links smaller sets under larger sets","[colby][union_find][sized_union_find]") {
+	GIVEN("A colby::sized_union_find containing singleton sets") {
+		sized_union_find sets(6);
+		WHEN("A set of three elements is united with a singleton") {
+			sets.unite(4,5);
+			auto large = sets.unite(3,sets.find(4));
+			auto rep = sets.unite(0,3);
+			THEN("The representative of the larger set represents the union") {
+				CHECK(rep == large);
+				for (int i : {0,3,4,5}) CHECK(sets.find(i) == large);
+			}
+			THEN("Other sets are unaffected") {
+				CHECK(sets.find(1) == 1);
+				CHECK(sets.find(2) == 2);
+			}
+			THEN("Uniting elements of the same set changes nothing") {
+				CHECK(sets.unite(0,5) == large);
+			}
+		}
+		WHEN("A long chain of elements is united one at a time") {
+			sized_union_find chain(1000);
+			for (int i = 999; i > 0; --i) chain.unite(i - 1,i);
+			THEN("They are all in the same set") {
+				auto rep = chain.find(0);
+				bool all = true;
+				for (int i = 0; i < 1000; ++i) if (chain.find(i) != rep) all = false;
+				CHECK(all);
+			}
+		}
+		WHEN("A set is added") {
+			auto i = sets.add();
+			THEN("It contains the next element") {
+				CHECK(i == 6);
+				CHECK(sets.size() == 7U);
+				CHECK(sets.find(6) == 6);
+			}
+		}
+	}
+}
+
+SCENARIO("colby::concurrent_union_find may be united from multiple threads","[colby][union_find][concurrent_union_find]") {
+	GIVEN("A colby::concurrent_union_find containing singleton sets") {
+		concurrent_union_find sets(1000);
+		WHEN("Every element is united with its neighbors concurrently") {
+			parallel_for(cv::Range(0,999),[&] (const cv::Range & range) {
+				for (int i = range.end - 1; i >= range.start; --i) sets.unite(i + 1,i);
+			});
+			THEN("All elements are in a single set represented by the smallest element") {
+				bool all = true;
+				for (int i = 0; i < 1000; ++i) if (sets.find(i) != 0) all = false;
+				CHECK(all);
+			}
+		}
+		WHEN("Every even element is united with the previous even element concurrently") {
+			parallel_for(cv::Range(1,500),[&] (const cv::Range & range) {
+				for (int i = range.start; i < range.end; ++i) sets.unite(i * 2,(i - 1) * 2);
+			});
+			THEN("The even and odd elements are partitioned correctly") {
+				bool correct = true;
+				for (int i = 0; i < 1000; ++i) if (sets.find(i) != ((i % 2) == 0 ? 0 : i)) correct = false;
+				CHECK(correct);
+			}
+		}
+	}
+}
+
+}
+}
+}
@@ -1,4 +1,5 @@
 #include <boost/program_options.hpp>
+#include <colby/async_sp3000_color_by_numbers_observer.hpp>
 #include <colby/optional.hpp>
 #include <colby/sp3000_color_by_numbers.hpp>
 #include <colby/sp3000_color_by_numbers_observer.hpp>
@@ -13,7 +14,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
-#include <thread>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -21,24 +22,25 @@ namespace {
 class observer : public colby::sp3000_color_by_numbers_observer {
 private:
 	bool show_;
-	colby::timer t_;
 	std::size_t n_merge_;
 	std::size_t flood_fill_;
 	std::size_t small_cells_;
-	std::vector<std::thread> ts_;
+	std::vector<std::pair<std::string,cv::Mat>> images_;
 	void show (const std::string & name, const base_event & e, std::size_t num = 0) {
 		if (!show_) return;
-		ts_.emplace_back([name,mat = e.image(),num] () {
-			std::ostringstream ss;
-			ss << "Sp3000 Color by Numbers - " << name;
-			if (num != 0) ss << " #" << num;
-			cv::imshow(ss.str(),mat);
-			cv::waitKey(0);
-		});
+		std::ostringstream ss;
+		ss << "Sp3000 Color by Numbers - " << name;
+		if (num != 0) ss << " #" << num;
+		images_.emplace_back(ss.str(),e.image());
 	}
-	void print (const char * str) {
-		std::cout << str << " (" << elapsed_string() << ')' << std::endl;
-		t_.restart();
+	void print (const char * str, const base_event & e) {
+		auto && s = e.statistics();
+		std::cout << str << " ("
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(s.elapsed).count() << " ms, "
+			<< s.regions << " regions, "
+			<< s.merges << " merges, "
+			<< s.pixels << " pixels visited, "
+			<< (s.peak_memory / (1024U * 1024U)) << " MiB peak)" << std::endl;
 	}
 public:
 	explicit observer (bool show = false)
@@ -47,42 +49,36 @@ public:
 			flood_fill_(0),
 			small_cells_(0)
 	{	}
-	~observer () noexcept {
-		for (auto && t : ts_) t.join();
-	}
-	colby::timer::duration elapsed () const {
-		return t_.elapsed();
-	}
-	std::string elapsed_string () const {
-		std::ostringstream ss;
-		ss << std::chrono::duration_cast<
-			std::chrono::milliseconds
-		>(elapsed()).count() << " ms";
-		return ss.str();
+	//	HighGUI is only used from the main thread so the
+	//	images are displayed once conversion is complete
+	void display () const {
+		if (images_.empty()) return;
+		for (auto && image : images_) cv::imshow(image.first,image.second);
+		cv::waitKey(0);
 	}
 	virtual void flood_fill (flood_fill_event e) override {
 		show("Flood Fill",e,++flood_fill_);
-		print("Flood fill complete!");
+		print("Flood fill complete!",e);
 	}
 	virtual void merge_small_cells (merge_small_cells_event e) override {
 		show("Merge Small Cells",e,++small_cells_);
-		print("Merge small cells complete!");
+		print("Merge small cells complete!",e);
 	}
 	virtual void merge_similar_cells (merge_similar_cells_event e) override {
 		show("Merge Similar Cells",e);
-		print("Merge similar cells complete!");
+		print("Merge similar cells complete!",e);
 	}
 	virtual void n_merge (n_merge_event e) override {
 		show("N-Merge",e,++n_merge_);
-		print("N-merge complete!");
+		print("N-merge complete!",e);
 	}
 	virtual void p_merge (p_merge_event e) override {
 		show("P-Merge",e);
-		print("P-merge complete!");
+		print("P-merge complete!",e);
 	}
 	virtual void gaussian_smooth (gaussian_smooth_event e) override {
 		show("Gaussian Smooth",e);
-		print("Gaussian smooth complete!");
+		print("Gaussian smooth complete!",e);
 	}
 };
 
@@ -126,10 +122,12 @@ static void main_impl (int argc, const char ** argv) {
 	std::cout << "Read " << opts->in << ".\n"
 		<< "Converting to color by numbers..." << std::endl;
 	observer o(true);
-	colby::sp3000_color_by_numbers impl(o,250,10);
+	colby::async_sp3000_color_by_numbers_observer async(o);
+	colby::sp3000_color_by_numbers impl(async,250,10);
 	colby::timer timer;
 	auto result = impl.convert(mat);
 	auto elapsed = timer.elapsed();
+	async.flush();
 	std::cout << "Converted to color by numbers (took "
 		<< std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms).\n"
 		<< "Saving to " << opts->out << "..." << std::endl;
@@ -139,6 +137,7 @@ static void main_impl (int argc, const char ** argv) {
 		throw std::runtime_error(ss.str());
 	}
 	std::cout << "Saved to " << opts->out << '.' << std::endl;
+	o.display();
 }
 
 int main (int argc, const char ** argv) {